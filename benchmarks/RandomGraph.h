@@ -0,0 +1,167 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#include "components.h"
+
+#include <DSPatch.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+// RandomGraph:
+// Generates seeded random layered DAGs of Work components into a circuit. Each level holds a random number of components, and
+// each component beyond the first level takes a random number of inputs from components in earlier levels (mostly the level
+// directly before it, but skipping back further with some probability). Component costs are drawn from a log-normal
+// distribution, so a shape can range from uniform to heavily skewed costs.
+
+struct GraphShape final
+{
+    std::string name;
+
+    int depth = 8;  // levels
+    int minWidth = 1;  // components per level
+    int maxWidth = 8;
+
+    int minFanIn = 1;  // inputs per component (beyond the first level)
+    int maxFanIn = 2;
+    double skipProbability = 0.1;  // chance of an input coming from further back than the previous level
+
+    double meanCost = 1000.0;  // spin iterations per Process_()
+    double costSpread = 0.0;  // log-normal sigma (0 = every component costs meanCost)
+};
+
+class RandomGraph final
+{
+public:
+    RandomGraph( const GraphShape& shape, unsigned seed )
+    {
+        std::mt19937 random( seed );
+
+        std::uniform_int_distribution<int> widthDistribution( shape.minWidth, shape.maxWidth );
+        std::uniform_int_distribution<int> fanInDistribution( shape.minFanIn, shape.maxFanIn );
+        std::bernoulli_distribution skipDistribution( shape.skipProbability );
+
+        // choose sigma and mu such that the log-normal mean is meanCost
+        const double mu = std::log( shape.meanCost ) - shape.costSpread * shape.costSpread / 2.0;
+        std::lognormal_distribution<double> costDistribution( mu, shape.costSpread );
+
+        std::vector<int> levelBegins;
+
+        for ( int level = 0; level < shape.depth; ++level )
+        {
+            levelBegins.emplace_back( (int)_nodes.size() );
+
+            const int width = widthDistribution( random );
+
+            for ( int i = 0; i < width; ++i )
+            {
+                Node node;
+                node.cost = std::max( 1, (int)std::lround( costDistribution( random ) ) );
+
+                if ( level != 0 )
+                {
+                    const int fanIn = fanInDistribution( random );
+
+                    for ( int j = 0; j < fanIn; ++j )
+                    {
+                        // pick a level to draw from: the previous one, or (with skipProbability) any earlier one
+                        int fromLevel = level - 1;
+                        if ( level > 1 && skipDistribution( random ) )
+                        {
+                            fromLevel = std::uniform_int_distribution<int>( 0, level - 2 )( random );
+                        }
+
+                        const int fromEnd = fromLevel + 1 < (int)levelBegins.size() ? levelBegins[fromLevel + 1]
+                                                                                     : (int)_nodes.size();
+                        node.inputs.emplace_back(
+                            std::uniform_int_distribution<int>( levelBegins[fromLevel], fromEnd - 1 )( random ) );
+                    }
+                }
+
+                _nodes.emplace_back( std::move( node ) );
+            }
+        }
+    }
+
+    int GetComponentCount() const
+    {
+        return (int)_nodes.size();
+    }
+
+    double GetTotalCost() const
+    {
+        double totalCost = 0.0;
+        for ( const auto& node : _nodes )
+        {
+            totalCost += node.cost;
+        }
+        return totalCost;
+    }
+
+    // adds the graph's components to circuit, returning the cost of each indexed by component handle (see Circuit::Analyze())
+    std::vector<double> Build( DSPatch::Circuit& circuit ) const
+    {
+        std::vector<DSPatch::Component::SPtr> components;
+        std::vector<double> costs;
+
+        for ( const auto& node : _nodes )
+        {
+            components.emplace_back( std::make_shared<Work>( (int)node.inputs.size(), node.cost ) );
+
+            circuit.AddComponent( components.back() );
+
+            const int handle = circuit.GetComponentHandle( components.back() );
+            costs.resize( std::max( (int)costs.size(), handle + 1 ), 0.0 );
+            costs[handle] = node.cost;
+        }
+
+        for ( int i = 0; i < (int)_nodes.size(); ++i )
+        {
+            for ( int j = 0; j < (int)_nodes[i].inputs.size(); ++j )
+            {
+                circuit.ConnectOutToIn( components[_nodes[i].inputs[j]], 0, components[i], j );
+            }
+        }
+
+        return costs;
+    }
+
+private:
+    struct Node final
+    {
+        int cost = 0;
+        std::vector<int> inputs;
+    };
+
+    std::vector<Node> _nodes;
+};
@@ -0,0 +1,227 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#include <DSPatch.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Source:
+// Source has 1 output.
+// This component outputs a new block of samples every tick.
+class Source final : public DSPatch::Component
+{
+public:
+    explicit Source( int blockSize )
+        : _blockSize( blockSize )
+    {
+        SetOutputCount_( 1 );
+    }
+
+protected:
+    void Process_( DSPatch::SignalBus&, DSPatch::SignalBus& outputs ) override
+    {
+        std::vector<float> block( _blockSize );
+        for ( int i = 0; i < _blockSize; ++i )
+        {
+            block[i] = (float)( ( _phase + i ) % 1024 ) / 1024.0f;
+        }
+        _phase += _blockSize;
+
+        outputs.MoveValue( 0, std::move( block ) );
+    }
+
+private:
+    const int _blockSize;
+    int _phase = 0;
+};
+
+// Gain:
+// Gain has 1 input and 1 output.
+// This component applies a soft-clipped gain to each sample of the block it receives.
+class Gain final : public DSPatch::Component
+{
+public:
+    explicit Gain( float gain )
+        : Component( ProcessOrder::OutOfOrder )
+        , _gain( gain )
+    {
+        SetInputCount_( 1 );
+        SetOutputCount_( 1 );
+    }
+
+protected:
+    void Process_( DSPatch::SignalBus& inputs, DSPatch::SignalBus& outputs ) override
+    {
+        auto block = inputs.GetValue<std::vector<float>>( 0 );
+        if ( !block )
+        {
+            return;
+        }
+
+        for ( auto& sample : *block )
+        {
+            sample = std::tanh( sample * _gain );
+        }
+
+        outputs.MoveSignal( 0, *inputs.GetSignal( 0 ) );
+    }
+
+private:
+    const float _gain;
+};
+
+// Mixer:
+// Mixer has N inputs and 1 output.
+// This component sums whichever of its input blocks it receives into one output block.
+class Mixer final : public DSPatch::Component
+{
+public:
+    explicit Mixer( int inputCount )
+        : Component( ProcessOrder::OutOfOrder )
+    {
+        SetInputCount_( inputCount );
+        SetOutputCount_( 1 );
+    }
+
+protected:
+    void Process_( DSPatch::SignalBus& inputs, DSPatch::SignalBus& outputs ) override
+    {
+        std::vector<float>* mix = nullptr;
+
+        for ( int i = 0; i < inputs.GetSignalCount(); ++i )
+        {
+            auto block = inputs.GetValue<std::vector<float>>( i );
+            if ( !block )
+            {
+                continue;
+            }
+
+            if ( !mix )
+            {
+                mix = block;
+                continue;
+            }
+
+            for ( size_t j = 0; j < mix->size() && j < block->size(); ++j )
+            {
+                ( *mix )[j] += ( *block )[j];
+            }
+        }
+
+        if ( mix )
+        {
+            outputs.MoveValue( 0, std::move( *mix ) );
+        }
+    }
+};
+
+// Sink:
+// Sink has 1 input.
+// This component records the time between each of its ticks (the circuit's tick interval).
+class Sink final : public DSPatch::Component
+{
+public:
+    Sink()
+    {
+        SetInputCount_( 1 );
+    }
+
+    std::vector<double> TakeIntervals()
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+
+        std::vector<double> intervals;
+        intervals.swap( _intervals );
+        return intervals;
+    }
+
+protected:
+    void Process_( DSPatch::SignalBus&, DSPatch::SignalBus& ) override
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        if ( _lastTick != std::chrono::steady_clock::time_point{} )
+        {
+            std::lock_guard<std::mutex> lock( _mutex );
+            _intervals.emplace_back( std::chrono::duration<double, std::micro>( now - _lastTick ).count() );
+        }
+
+        _lastTick = now;
+    }
+
+private:
+    std::mutex _mutex;
+    std::vector<double> _intervals;  // in microseconds
+    std::chrono::steady_clock::time_point _lastTick;
+};
+
+// Work:
+// Work has N inputs and 1 output.
+// This component sums whichever of its integer inputs it receives, then spins for a fixed number of iterations (its synthetic
+// cost) before outputting the result.
+class Work final : public DSPatch::Component
+{
+public:
+    Work( int inputCount, int cost )
+        : Component( ProcessOrder::OutOfOrder )
+        , _cost( cost )
+    {
+        SetInputCount_( inputCount );
+        SetOutputCount_( 1 );
+    }
+
+protected:
+    void Process_( DSPatch::SignalBus& inputs, DSPatch::SignalBus& outputs ) override
+    {
+        uint32_t value = 1;
+
+        for ( int i = 0; i < inputs.GetSignalCount(); ++i )
+        {
+            if ( auto input = inputs.GetValue<uint32_t>( i ) )
+            {
+                value += *input;
+            }
+        }
+
+        for ( int i = 0; i < _cost; ++i )
+        {
+            value = value * 1664525u + 1013904223u;
+        }
+
+        outputs.SetValue( 0, value );
+    }
+
+private:
+    const int _cost;
+};
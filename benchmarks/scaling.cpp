@@ -0,0 +1,178 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#include "RandomGraph.h"
+
+#include <DSPatch.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <utility>
+
+// Scaling:
+// Generates many seeded random graphs per shape class (see RandomGraph), and measures each one's tick rate across a range of
+// thread and buffer counts. Per-graph results are printed as CSV, and each shape class's scaling curve (the median, min and max
+// speedup over single-threaded, single-buffered ticking per configuration, alongside the median speedup Circuit::Analyze()
+// predicts) is written to "<output directory>/<shape>.csv".
+//
+// Usage: Scaling [graphs per shape = 10] [ticks per measurement = 200] [output directory = .] [seed = 0]
+
+namespace
+{
+
+const std::vector<GraphShape> shapes = {
+    // name, depth, min / max width, min / max fan-in, skip probability, mean cost, cost spread
+    { "chain", 32, 1, 1, 1, 1, 0.0, 1000.0, 0.0 },
+    { "wide", 2, 32, 48, 1, 1, 0.0, 1000.0, 0.0 },
+    { "layered", 12, 4, 12, 1, 3, 0.1, 1000.0, 0.0 },
+    { "skewed", 12, 4, 12, 1, 3, 0.1, 1000.0, 1.5 },
+    { "narrow", 48, 1, 3, 1, 2, 0.2, 1000.0, 0.5 },
+};
+
+double Median( std::vector<double> values )
+{
+    std::sort( values.begin(), values.end() );
+    return values.empty() ? 0.0 : values[values.size() / 2];
+}
+
+double TicksPerSecond( DSPatch::Circuit& circuit, int tickCount )
+{
+    // warm up (allocations, thread start-up, and filling the buffer pipeline)
+    for ( int i = 0; i < 2 * circuit.GetBufferCount() + 8; ++i )
+    {
+        circuit.Tick();
+    }
+    circuit.Sync();
+
+    const auto begin = std::chrono::steady_clock::now();
+
+    for ( int i = 0; i < tickCount; ++i )
+    {
+        circuit.Tick();
+    }
+    circuit.Sync();
+
+    const auto seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - begin ).count();
+    return tickCount / seconds;
+}
+
+}  // namespace
+
+int main( int argc, char* argv[] )
+{
+    const int graphCount = argc > 1 ? std::max( 1, std::atoi( argv[1] ) ) : 10;
+    const int tickCount = argc > 2 ? std::max( 1, std::atoi( argv[2] ) ) : 200;
+    const std::string outputDir = argc > 3 ? argv[3] : ".";
+    const unsigned seed = argc > 4 ? (unsigned)std::atoi( argv[4] ) : 0;
+
+    // thread counts: 0 (ticked on the calling thread), then powers of 2 up to the core count
+    std::vector<int> threadCounts = { 0 };
+    for ( int threadCount = 1; threadCount <= (int)std::max( 1u, std::thread::hardware_concurrency() ); threadCount *= 2 )
+    {
+        threadCounts.emplace_back( threadCount );
+    }
+    const std::vector<int> bufferCounts = { 1, 2, 4 };
+
+    std::printf( "shape,seed,components,total_cost,threads,buffers,ticks_per_sec,speedup,predicted_speedup\n" );
+
+    for ( const auto& shape : shapes )
+    {
+        // speedups (measured, predicted) per configuration (threads, buffers), across every graph of this shape
+        std::map<std::pair<int, int>, std::pair<std::vector<double>, std::vector<double>>> speedups;
+
+        for ( int graphNo = 0; graphNo < graphCount; ++graphNo )
+        {
+            const unsigned graphSeed = seed + graphNo;
+            const RandomGraph graph( shape, graphSeed );
+
+            DSPatch::Circuit circuit;
+            const auto costs = graph.Build( circuit );
+            const auto analyzer = circuit.Analyze( costs );
+
+            double baseline = 0.0;
+            double predictedBaseline = 0.0;
+
+            for ( auto threadCount : threadCounts )
+            {
+                for ( auto bufferCount : bufferCounts )
+                {
+                    circuit.SetBufferCount( bufferCount );
+                    circuit.SetThreadCount( threadCount );
+
+                    const auto ticksPerSecond = TicksPerSecond( circuit, tickCount );
+                    const auto predicted = analyzer.Simulate( bufferCount, threadCount ).throughput;
+
+                    if ( threadCount == 0 && bufferCount == 1 )
+                    {
+                        baseline = ticksPerSecond;
+                        predictedBaseline = predicted;
+                    }
+
+                    const auto speedup = ticksPerSecond / baseline;
+                    const auto predictedSpeedup = predicted / predictedBaseline;
+
+                    auto& configSpeedups = speedups[{ threadCount, bufferCount }];
+                    configSpeedups.first.emplace_back( speedup );
+                    configSpeedups.second.emplace_back( predictedSpeedup );
+
+                    std::printf( "%s,%u,%d,%.0f,%d,%d,%.1f,%.3f,%.3f\n",
+                                 shape.name.c_str(),
+                                 graphSeed,
+                                 graph.GetComponentCount(),
+                                 graph.GetTotalCost(),
+                                 threadCount,
+                                 bufferCount,
+                                 ticksPerSecond,
+                                 speedup,
+                                 predictedSpeedup );
+                    std::fflush( stdout );
+                }
+            }
+        }
+
+        std::ofstream curve( outputDir + "/" + shape.name + ".csv" );
+        curve << "threads,buffers,median_speedup,min_speedup,max_speedup,median_predicted_speedup\n";
+
+        for ( const auto& configSpeedups : speedups )
+        {
+            const auto& measured = configSpeedups.second.first;
+
+            curve << configSpeedups.first.first << "," << configSpeedups.first.second << "," << Median( measured ) << ","
+                  << *std::min_element( measured.begin(), measured.end() ) << ","
+                  << *std::max_element( measured.begin(), measured.end() ) << ","
+                  << Median( configSpeedups.second.second ) << "\n";
+        }
+    }
+
+    return 0;
+}
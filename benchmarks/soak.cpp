@@ -0,0 +1,213 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#include "components.h"
+
+#include <DSPatch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+// Soak:
+// Runs an auto-ticking circuit for a long period while a control thread keeps rewiring it, adding and removing components, and
+// changing its buffer count, thread count and scheduling. Every report interval, the tick rate, tick interval percentiles, and
+// the durations of the control thread's changes (each of which pauses the auto-tick) are printed as a row of CSV.
+//
+// Usage: Soak [seconds = 60] [report interval seconds = 5] [seed = 0]
+
+namespace
+{
+
+constexpr int chainCount = 8;
+constexpr int chainLength = 8;
+constexpr int blockSize = 256;
+constexpr int maxExtraCount = 8;
+
+double Percentile( std::vector<double>& values, double percentile )
+{
+    if ( values.empty() )
+    {
+        return 0.0;
+    }
+
+    const auto n = std::min( values.size() - 1, (size_t)( percentile / 100.0 * values.size() ) );
+    std::nth_element( values.begin(), values.begin() + n, values.end() );
+    return values[n];
+}
+
+double Max( const std::vector<double>& values )
+{
+    return values.empty() ? 0.0 : *std::max_element( values.begin(), values.end() );
+}
+
+}  // namespace
+
+int main( int argc, char* argv[] )
+{
+    const int seconds = argc > 1 ? std::atoi( argv[1] ) : 60;
+    const int reportInterval = argc > 2 ? std::max( 1, std::atoi( argv[2] ) ) : 5;
+    const unsigned seed = argc > 3 ? (unsigned)std::atoi( argv[3] ) : 0;
+
+    const int maxThreadCount = std::max( 2, (int)std::thread::hardware_concurrency() );
+
+    // 1. Build a circuit: source -> chainCount chains of gains -> mixer -> sink
+    auto circuit = std::make_shared<DSPatch::Circuit>();
+
+    auto source = std::make_shared<Source>( blockSize );
+    auto mixer = std::make_shared<Mixer>( chainCount );
+    auto sink = std::make_shared<Sink>();
+
+    circuit->AddComponent( source );
+    circuit->AddComponent( mixer );
+    circuit->AddComponent( sink );
+
+    std::vector<std::vector<DSPatch::Component::SPtr>> chains( chainCount );
+
+    for ( int i = 0; i < chainCount; ++i )
+    {
+        DSPatch::Component::SPtr last = source;
+
+        for ( int j = 0; j < chainLength; ++j )
+        {
+            chains[i].emplace_back( std::make_shared<Gain>( 0.5f + 0.1f * j ) );
+            circuit->AddComponent( chains[i].back() );
+            circuit->ConnectOutToIn( last, 0, chains[i].back(), 0 );
+            last = chains[i].back();
+        }
+
+        circuit->ConnectOutToIn( last, 0, mixer, i );
+    }
+
+    circuit->ConnectOutToIn( mixer, 0, sink, 0 );
+
+    circuit->SetBufferCount( 2 );
+    circuit->SetThreadCount( 2 );
+
+    // 2. Start the circuit, and a control thread that keeps changing it
+    circuit->StartAutoTick();
+
+    std::atomic<bool> stop = false;
+    std::mutex pausesMutex;
+    std::vector<double> pauses;  // in milliseconds
+
+    std::thread control( [&] {
+        std::mt19937 random( seed );
+        std::vector<DSPatch::Component::SPtr> extras;
+
+        while ( !stop )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 + random() % 20 ) );
+
+            const auto begin = std::chrono::steady_clock::now();
+
+            switch ( random() % 6 )
+            {
+                case 0:
+                case 1:
+                {
+                    // rewire a stage's input to the previous stage of a random chain (stages only ever feed later stages)
+                    const int stage = random() % chainLength;
+                    auto& to = chains[random() % chainCount][stage];
+                    auto from = stage == 0 ? DSPatch::Component::SPtr( source ) : chains[random() % chainCount][stage - 1];
+                    circuit->ConnectOutToIn( from, 0, to, 0 );
+                    break;
+                }
+                case 2:
+                {
+                    // add a component tapping a random stage, or remove one added before
+                    if ( extras.size() < maxExtraCount && random() % 2 == 0 )
+                    {
+                        extras.emplace_back( std::make_shared<Gain>( 1.0f ) );
+                        circuit->AddComponent( extras.back() );
+                        circuit->ConnectOutToIn( chains[random() % chainCount][random() % chainLength], 0, extras.back(), 0 );
+                    }
+                    else if ( !extras.empty() )
+                    {
+                        circuit->RemoveComponent( extras.back() );
+                        extras.pop_back();
+                    }
+                    break;
+                }
+                case 3:
+                    circuit->SetBufferCount( 1 + random() % 4 );
+                    break;
+                case 4:
+                    circuit->SetThreadCount( random() % ( maxThreadCount + 1 ) );
+                    break;
+                case 5:
+                    circuit->SetScheduling( (DSPatch::Circuit::Scheduling)( random() % 3 ) );
+                    break;
+            }
+
+            const auto end = std::chrono::steady_clock::now();
+
+            std::lock_guard<std::mutex> lock( pausesMutex );
+            pauses.emplace_back( std::chrono::duration<double, std::milli>( end - begin ).count() );
+        }
+    } );
+
+    // 3. Report every interval until done
+    std::printf( "seconds,ticks_per_sec,tick_p50_us,tick_p99_us,tick_max_us,changes,pause_p99_ms,pause_max_ms,buffers,threads\n" );
+
+    for ( int elapsed = reportInterval; elapsed <= seconds; elapsed += reportInterval )
+    {
+        std::this_thread::sleep_for( std::chrono::seconds( reportInterval ) );
+
+        auto intervals = sink->TakeIntervals();
+
+        std::vector<double> intervalPauses;
+        {
+            std::lock_guard<std::mutex> lock( pausesMutex );
+            intervalPauses.swap( pauses );
+        }
+
+        std::printf( "%d,%.0f,%.1f,%.1f,%.1f,%zu,%.3f,%.3f,%d,%d\n",
+                     elapsed,
+                     (double)intervals.size() / reportInterval,
+                     Percentile( intervals, 50.0 ),
+                     Percentile( intervals, 99.0 ),
+                     Max( intervals ),
+                     intervalPauses.size(),
+                     Percentile( intervalPauses, 99.0 ),
+                     Max( intervalPauses ),
+                     circuit->GetBufferCount(),
+                     circuit->GetThreadCount() );
+        std::fflush( stdout );
+    }
+
+    stop = true;
+    control.join();
+
+    circuit->StopAutoTick();
+
+    return 0;
+}
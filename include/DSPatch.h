@@ -28,7 +28,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include "dspatch/AsyncComponent.h"
 #include "dspatch/Circuit.h"
+#include "dspatch/CircuitBridge.h"
+#include "dspatch/ClockBridge.h"
+#include "dspatch/Injector.h"
 #include "dspatch/Plugin.h"
 
 /**
@@ -0,0 +1,291 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace DSPatch
+{
+
+/// Offline circuit schedule analyzer
+
+/**
+An Analyzer predicts how a circuit would scale, given the cost of each of its components (E.g. measured cycles via
+Component::GetPerfCounts(), or estimates). Analyzers are usually obtained via Circuit::Analyze(), but can also be constructed
+directly from a list of nodes for "what-if" graphs. Nodes must be listed in series (topological) order, where each node's inputs
+refer to the indices of the nodes feeding it. Inputs from later nodes are treated as feedback, and ignored.
+
+GetCriticalPath() returns the chain of nodes with the greatest total cost, which bounds the duration of a single tick no matter
+how many threads are available. GetLevels() reports the work available in parallel at each level of the circuit (the levels a
+multi-threaded circuit is ordered by), and GetSpeedupBound() the theoretical limit of multi-threading: total cost / critical path
+cost.
+
+Simulate() plays the circuit through a model of the engine's scheduler for a given buffer and thread count: components are
+strided across threads in level order (or run in series when there are no threads), each waits for its inputs, in-order
+components wait for their previous tick, and each buffer waits for its previous tick before starting a new one. The resulting
+steady-state tick interval predicts throughput for that SetBufferCount() / SetThreadCount() combination. Predict() simulates every
+combination up to the counts given.
+
+<b>NOTE:</b> The model assumes a dedicated core per thread, and no synchronization overhead. Its predictions are upper bounds to be
+compared against each other, rather than absolute figures.
+*/
+
+class Analyzer final
+{
+public:
+    struct Node final
+    {
+        int id = -1;  // E.g. component handle
+        double cost = 0.0;
+        bool inOrder = true;
+        std::vector<int> inputs;  // indices of input nodes
+    };
+
+    struct Level final
+    {
+        int nodeCount = 0;
+        double cost = 0.0;
+    };
+
+    struct Prediction final
+    {
+        int bufferCount = 0;
+        int threadCount = 0;
+        double tickInterval = 0.0;  // steady-state time between completed ticks
+        double throughput = 0.0;    // ticks per unit of cost
+    };
+
+    explicit Analyzer( std::vector<Node> nodes );
+
+    const std::vector<Node>& GetNodes() const;
+
+    double GetTotalCost() const;
+    double GetCriticalPathCost() const;
+    std::vector<int> GetCriticalPath() const;
+
+    const std::vector<Level>& GetLevels() const;
+
+    double GetSpeedupBound() const;
+
+    Prediction Simulate( int bufferCount, int threadCount, int tickCount = 64 ) const;
+    std::vector<Prediction> Predict( int maxBufferCount, int maxThreadCount, int tickCount = 64 ) const;
+
+private:
+    std::vector<Node> _nodes;
+    std::vector<int> _nodeLevels;
+    std::vector<Level> _levels;
+    std::vector<double> _pathCosts;   // greatest cost of any path ending at each node
+    std::vector<int> _pathInputs;     // input on that path per node (-1 if none)
+    double _totalCost = 0.0;
+};
+
+inline Analyzer::Analyzer( std::vector<Node> nodes )
+    : _nodes( std::move( nodes ) )
+    , _nodeLevels( _nodes.size(), 0 )
+    , _pathCosts( _nodes.size(), 0.0 )
+    , _pathInputs( _nodes.size(), -1 )
+{
+    for ( int i = 0; i < (int)_nodes.size(); ++i )
+    {
+        const auto& node = _nodes[i];
+
+        double inputPathCost = 0.0;
+
+        for ( auto input : node.inputs )
+        {
+            if ( input < 0 || input >= i )
+            {
+                continue;  // feedback
+            }
+
+            _nodeLevels[i] = std::max( _nodeLevels[i], _nodeLevels[input] + 1 );
+
+            if ( _pathInputs[i] == -1 || _pathCosts[input] > inputPathCost )
+            {
+                inputPathCost = _pathCosts[input];
+                _pathInputs[i] = input;
+            }
+        }
+
+        _pathCosts[i] = inputPathCost + node.cost;
+        _totalCost += node.cost;
+
+        if ( _nodeLevels[i] >= (int)_levels.size() )
+        {
+            _levels.resize( _nodeLevels[i] + 1 );
+        }
+
+        ++_levels[_nodeLevels[i]].nodeCount;
+        _levels[_nodeLevels[i]].cost += node.cost;
+    }
+}
+
+// cppcheck-suppress unusedFunction
+inline const std::vector<Analyzer::Node>& Analyzer::GetNodes() const
+{
+    return _nodes;
+}
+
+inline double Analyzer::GetTotalCost() const
+{
+    return _totalCost;
+}
+
+inline double Analyzer::GetCriticalPathCost() const
+{
+    return _pathCosts.empty() ? 0.0 : *std::max_element( _pathCosts.begin(), _pathCosts.end() );
+}
+
+inline std::vector<int> Analyzer::GetCriticalPath() const
+{
+    std::vector<int> criticalPath;
+
+    if ( _pathCosts.empty() )
+    {
+        return criticalPath;
+    }
+
+    // walk back from the node ending the costliest path
+    for ( int i = (int)( std::max_element( _pathCosts.begin(), _pathCosts.end() ) - _pathCosts.begin() ); i != -1;
+          i = _pathInputs[i] )
+    {
+        criticalPath.emplace_back( _nodes[i].id );
+    }
+
+    std::reverse( criticalPath.begin(), criticalPath.end() );
+
+    return criticalPath;
+}
+
+inline const std::vector<Analyzer::Level>& Analyzer::GetLevels() const
+{
+    return _levels;
+}
+
+inline double Analyzer::GetSpeedupBound() const
+{
+    const auto criticalPathCost = GetCriticalPathCost();
+    return criticalPathCost > 0.0 ? _totalCost / criticalPathCost : 1.0;
+}
+
+inline Analyzer::Prediction Analyzer::Simulate( int bufferCount, int threadCount, int tickCount ) const
+{
+    Prediction prediction;
+    prediction.bufferCount = bufferCount;
+    prediction.threadCount = threadCount;
+
+    const int nodeCount = (int)_nodes.size();
+    const int buffers = std::max( bufferCount, 1 );
+    const int threads = std::max( threadCount, 1 );
+    tickCount = std::max( tickCount, 2 * buffers );
+
+    // order nodes as the circuit would: series order, or level order when threaded (see Circuit::Optimize())
+    std::vector<int> order( nodeCount );
+    for ( int i = 0; i < nodeCount; ++i )
+    {
+        order[i] = i;
+    }
+    if ( threadCount != 0 )
+    {
+        std::stable_sort( order.begin(), order.end(), [this]( int a, int b ) { return _nodeLevels[a] < _nodeLevels[b]; } );
+    }
+
+    std::vector<double> tickStarts( tickCount, 0.0 );
+    std::vector<double> tickFinishes( tickCount, 0.0 );
+    std::vector<double> finishes( nodeCount, 0.0 );      // finish time per node, this tick
+    std::vector<double> lastFinishes( nodeCount, 0.0 );  // finish time per node, last tick
+    std::vector<double> threadTimes( threads );
+
+    for ( int tick = 0; tick < tickCount; ++tick )
+    {
+        // a buffer's threads sync with its previous tick before starting this one
+        tickStarts[tick] = tick == 0 ? 0.0 : tickStarts[tick - 1];
+        if ( tick >= buffers )
+        {
+            tickStarts[tick] = std::max( tickStarts[tick], tickFinishes[tick - buffers] );
+        }
+
+        std::fill( threadTimes.begin(), threadTimes.end(), tickStarts[tick] );
+
+        // components are strided across threads, and processed by each thread in order
+        for ( int i = 0; i < nodeCount; ++i )
+        {
+            const int nodeNo = order[i];
+            const auto& node = _nodes[nodeNo];
+            auto& threadTime = threadTimes[i % threads];
+
+            double start = threadTime;
+
+            for ( auto input : node.inputs )
+            {
+                if ( input >= 0 && input < nodeNo )
+                {
+                    start = std::max( start, finishes[input] );
+                }
+            }
+
+            if ( node.inOrder && bufferCount > 1 )
+            {
+                start = std::max( start, lastFinishes[nodeNo] );
+            }
+
+            finishes[nodeNo] = start + node.cost;
+            threadTime = finishes[nodeNo];
+        }
+
+        tickFinishes[tick] = *std::max_element( threadTimes.begin(), threadTimes.end() );
+        lastFinishes.swap( finishes );
+    }
+
+    // measure the steady state over the second half of the simulated ticks
+    const int firstTick = tickCount / 2;
+    prediction.tickInterval = ( tickFinishes[tickCount - 1] - tickFinishes[firstTick - 1] ) / ( tickCount - firstTick );
+    prediction.throughput = prediction.tickInterval > 0.0 ? 1.0 / prediction.tickInterval : 0.0;
+
+    return prediction;
+}
+
+inline std::vector<Analyzer::Prediction> Analyzer::Predict( int maxBufferCount, int maxThreadCount, int tickCount ) const
+{
+    std::vector<Prediction> predictions;
+
+    for ( int bufferCount = 0; bufferCount <= maxBufferCount; ++bufferCount )
+    {
+        for ( int threadCount = 0; threadCount <= maxThreadCount; ++threadCount )
+        {
+            predictions.emplace_back( Simulate( bufferCount, threadCount, tickCount ) );
+        }
+    }
+
+    return predictions;
+}
+
+}  // namespace DSPatch
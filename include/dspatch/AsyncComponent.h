@@ -0,0 +1,308 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#if defined( __has_include )
+#if __has_include( <coroutine> ) && defined( __cpp_impl_coroutine )
+#define DSPATCH_COROUTINES
+#endif
+#endif
+
+#ifdef DSPATCH_COROUTINES
+
+#include "Component.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <utility>
+
+namespace DSPatch
+{
+
+/// Component with a coroutine process method (C++20)
+
+/**
+Components that wait on I/O or external services would otherwise block their tick thread within Process_(), and (if in-order)
+hold up every other buffer's Process_() call for as long as they wait. An AsyncComponent instead implements ProcessAsync_() as a
+C++20 coroutine, which can co_await asynchronous results via Await_() (E.g. co_await Await_( std::async( ... ) )).
+
+Note that a suspended coroutine doesn't free its buffer's thread: the thread is parked, blocking on the awaited result (E.g. in
+std::future::wait()) until it's ready, then resumes the coroutine. The component's tick (and so its outputs) is only complete once
+ProcessAsync_() returns.
+
+For an out-of-order AsyncComponent, the waits of concurrent buffers overlap, as its coroutines run freely (so ProcessAsync_() must
+be thread-safe). For an in-order AsyncComponent, ProcessAsync_() calls run strictly one after another, in buffer order, so the
+component needn't be thread-safe, and everything its coroutines do (before and after each co_await) happens in buffer order. When
+a call first suspends, the next buffer's call is released (see Component::ReleaseNextBuffer_()), but only to park its own thread
+until the suspended call returns (rather than spinning on its release while this call waits).
+
+AsyncComponent is only available when compiling as C++20 (or later) with coroutine support, in which case DSPATCH_COROUTINES is
+defined.
+*/
+
+class AsyncComponent : public Component
+{
+public:
+    class Task final
+    {
+    public:
+        struct promise_type final
+        {
+            Task get_return_object();
+
+            std::suspend_always initial_suspend() noexcept;
+            std::suspend_always final_suspend() noexcept;
+
+            void return_void();
+            void unhandled_exception();
+
+            void ( *wait )( void* ) = nullptr;
+            void* waitContext = nullptr;
+
+            std::exception_ptr exception;
+        };
+
+        Task( const Task& ) = delete;
+        Task& operator=( const Task& ) = delete;
+
+        Task( Task&& rhs ) noexcept;
+        ~Task();
+
+    private:
+        friend class AsyncComponent;
+
+        explicit Task( std::coroutine_handle<promise_type> handle );
+
+        std::coroutine_handle<promise_type> _handle;
+    };
+
+    template <typename ValueType>
+    class FutureAwaiter final
+    {
+    public:
+        explicit FutureAwaiter( std::future<ValueType>&& future );
+
+        bool await_ready() const;
+        void await_suspend( std::coroutine_handle<Task::promise_type> handle );
+        ValueType await_resume();
+
+    private:
+        static void _Wait( void* awaiter );
+
+        std::future<ValueType> _future;
+    };
+
+    explicit AsyncComponent( ProcessOrder processOrder = ProcessOrder::InOrder );
+
+protected:
+    virtual Task ProcessAsync_( SignalBus& inputs, SignalBus& outputs ) = 0;
+
+    template <typename ValueType>
+    static FutureAwaiter<ValueType> Await_( std::future<ValueType>&& future );
+
+    void Process_( SignalBus& inputs, SignalBus& outputs ) final;
+
+private:
+    void _WaitForTurn( uint64_t ticket );
+    void _PassTurn( uint64_t ticket );
+
+    static void _Resume( Task& task );
+
+    std::mutex _turnMutex;
+    std::condition_variable _turnCondt;
+    uint64_t _nextTicket = 0;      // tickets are taken by in-order calls as they start, in buffer order
+    uint64_t _returnedTicket = 0;  // all calls with earlier tickets have returned
+};
+
+inline AsyncComponent::Task AsyncComponent::Task::promise_type::get_return_object()
+{
+    return Task( std::coroutine_handle<promise_type>::from_promise( *this ) );
+}
+
+inline std::suspend_always AsyncComponent::Task::promise_type::initial_suspend() noexcept
+{
+    // don't start until Process_() resumes us (in turn)
+    return {};
+}
+
+inline std::suspend_always AsyncComponent::Task::promise_type::final_suspend() noexcept
+{
+    // keep the coroutine frame around until its Task is done with it
+    return {};
+}
+
+inline void AsyncComponent::Task::promise_type::return_void()
+{
+}
+
+inline void AsyncComponent::Task::promise_type::unhandled_exception()
+{
+    exception = std::current_exception();
+}
+
+inline AsyncComponent::Task::Task( std::coroutine_handle<promise_type> handle )
+    : _handle( handle )
+{
+}
+
+inline AsyncComponent::Task::Task( Task&& rhs ) noexcept
+    : _handle( std::exchange( rhs._handle, nullptr ) )
+{
+}
+
+inline AsyncComponent::Task::~Task()
+{
+    if ( _handle )
+    {
+        _handle.destroy();
+    }
+}
+
+template <typename ValueType>
+inline AsyncComponent::FutureAwaiter<ValueType>::FutureAwaiter( std::future<ValueType>&& future )
+    : _future( std::move( future ) )
+{
+}
+
+template <typename ValueType>
+inline bool AsyncComponent::FutureAwaiter<ValueType>::await_ready() const
+{
+    return _future.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready;
+}
+
+template <typename ValueType>
+inline void AsyncComponent::FutureAwaiter<ValueType>::await_suspend( std::coroutine_handle<Task::promise_type> handle )
+{
+    // tell Process_() what to wait on before resuming us (we live in the coroutine frame until then)
+    handle.promise().wait = &_Wait;
+    handle.promise().waitContext = this;
+}
+
+template <typename ValueType>
+inline ValueType AsyncComponent::FutureAwaiter<ValueType>::await_resume()
+{
+    return _future.get();
+}
+
+template <typename ValueType>
+inline void AsyncComponent::FutureAwaiter<ValueType>::_Wait( void* awaiter )
+{
+    static_cast<FutureAwaiter*>( awaiter )->_future.wait();
+}
+
+inline AsyncComponent::AsyncComponent( ProcessOrder processOrder )
+    : Component( processOrder )
+{
+}
+
+template <typename ValueType>
+inline AsyncComponent::FutureAwaiter<ValueType> AsyncComponent::Await_( std::future<ValueType>&& future )
+{
+    return FutureAwaiter<ValueType>( std::move( future ) );
+}
+
+inline void AsyncComponent::Process_( SignalBus& inputs, SignalBus& outputs )
+{
+    auto task = ProcessAsync_( inputs, outputs );
+    auto& promise = task._handle.promise();
+
+    const bool inOrder = GetProcessOrder() == ProcessOrder::InOrder;
+
+    // (in-order calls are serialized up to the first ReleaseNextBuffer_(), so we can take our ticket without the lock)
+    const auto ticket = inOrder ? _nextTicket++ : 0;
+
+    if ( inOrder )
+    {
+        _WaitForTurn( ticket );
+    }
+
+    // run up to the first suspension
+    _Resume( task );
+
+    if ( !task._handle.done() )
+    {
+        // let the next buffer's call begin (and park until we return) while we wait
+        ReleaseNextBuffer_();
+
+        do
+        {
+            if ( promise.wait )
+            {
+                promise.wait( promise.waitContext );
+            }
+            _Resume( task );
+        } while ( !task._handle.done() );
+    }
+
+    if ( inOrder )
+    {
+        _PassTurn( ticket );
+    }
+
+    if ( promise.exception )
+    {
+        std::rethrow_exception( promise.exception );
+    }
+}
+
+inline void AsyncComponent::_WaitForTurn( uint64_t ticket )
+{
+    // You might be thinking: Why wait here when in-order Process_() calls are already serialized?
+
+    // They are only until ReleaseNextBuffer_() is called. From then on, the next buffer's call may begin
+    // while ours is still suspended. If it were to start its coroutine right away, its parts could run
+    // between ours (and it could even return first), so it waits for every earlier call to return.
+
+    std::unique_lock<std::mutex> lock( _turnMutex );
+    _turnCondt.wait( lock, [this, ticket] { return _returnedTicket == ticket; } );
+}
+
+inline void AsyncComponent::_PassTurn( uint64_t ticket )
+{
+    {
+        std::lock_guard<std::mutex> lock( _turnMutex );
+        _returnedTicket = ticket + 1;
+    }
+    _turnCondt.notify_all();
+}
+
+inline void AsyncComponent::_Resume( Task& task )
+{
+    task._handle.promise().wait = nullptr;
+    task._handle.resume();
+}
+
+}  // namespace DSPatch
+
+#endif  // DSPATCH_COROUTINES
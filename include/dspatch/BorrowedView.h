@@ -0,0 +1,124 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace DSPatch
+{
+
+/// Read-only view of externally owned memory
+
+/**
+A BorrowedView lets a large externally owned block of memory (E.g. a DMA region, a mmap'd file, or a network buffer) flow
+through a circuit as a signal without being copied into it. The owner supplies a pointer, an element count, and a release
+callback. Copying a view (as happens when an output fans out to several inputs) only shares it, and the release callback is
+called exactly once, when the last copy of the view is destroyed.
+
+Views are placed into a SignalBus via SignalBus::BorrowValue(), and read back via SignalBus::GetBorrowedValue(). As signals are
+cleared on every tick, the release callback fires once every component downstream has processed the tick that carried the
+view (or sooner, if a component replaces or clears the signal). The release callback may be called from any circuit thread.
+
+<b>NOTE:</b> The owner must keep the memory valid and unchanged until the release callback is called.
+*/
+
+template <typename ValueType>
+class BorrowedView final
+{
+public:
+    BorrowedView() = default;
+    BorrowedView( const ValueType* data, size_t size, std::function<void()> release );
+
+    const ValueType* GetData() const;
+    size_t GetSize() const;
+    long GetUseCount() const;
+
+    const ValueType& operator[]( size_t index ) const;
+
+    const ValueType* begin() const;
+    const ValueType* end() const;
+
+private:
+    std::shared_ptr<const ValueType> _data;
+    size_t _size = 0;
+};
+
+template <typename ValueType>
+inline BorrowedView<ValueType>::BorrowedView( const ValueType* data, size_t size, std::function<void()> release )
+    : _data( data,
+             [release = std::move( release )]( const ValueType* ) {
+                 if ( release )
+                 {
+                     release();
+                 }
+             } )
+    , _size( size )
+{
+}
+
+template <typename ValueType>
+inline const ValueType* BorrowedView<ValueType>::GetData() const
+{
+    return _data.get();
+}
+
+template <typename ValueType>
+inline size_t BorrowedView<ValueType>::GetSize() const
+{
+    return _size;
+}
+
+template <typename ValueType>
+inline long BorrowedView<ValueType>::GetUseCount() const
+{
+    return _data.use_count();
+}
+
+template <typename ValueType>
+inline const ValueType& BorrowedView<ValueType>::operator[]( size_t index ) const
+{
+    return _data.get()[index];
+}
+
+template <typename ValueType>
+inline const ValueType* BorrowedView<ValueType>::begin() const
+{
+    return _data.get();
+}
+
+template <typename ValueType>
+inline const ValueType* BorrowedView<ValueType>::end() const
+{
+    return _data.get() + _size;
+}
+
+}  // namespace DSPatch
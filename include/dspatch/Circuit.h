@@ -28,6 +28,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include "Analyzer.h"
 #include "Component.h"
 
 #ifdef _WIN32
@@ -37,9 +38,17 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 
 #include <algorithm>
+#include <chrono>
 #include <condition_variable>
-#include <set>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <numeric>
 #include <thread>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 namespace DSPatch
 {
@@ -50,6 +59,14 @@ namespace DSPatch
 Components can be added to a Circuit via the AddComponent() method, and routed to and from other components via the
 ConnectOutToIn() method.
 
+Each added component is assigned a compact integer handle, retrievable via GetComponentHandle(). Every wiring method has a
+handle-based overload that indexes straight into the circuit's component table, avoiding any lookups by pointer. Handles of
+removed components are recycled for components added thereafter.
+
+AddComponent() also records the class each component was added as (E.g. Counter, for a std::shared_ptr<Counter>). Every tick then
+calls a tick function instantiated for that class (see Component::TickAs()), walking flat plans of ( tick function, component )
+entries that Optimize() lays out in tick order. A component added as a plain Component::SPtr is ticked via Component::Tick().
+
 <b>NOTE:</b> Each component input can only accept a single "wire" at a time. When a wire is connected to an input that already has
 a connected wire, that wire is replaced with the new one. One output, on the other hand, can be distributed to multiple inputs.
 
@@ -64,9 +81,69 @@ The Circuit Tick() method runs through its internal array of components and call
 Tick() method can be called in a loop from the main application thread, or alternatively, by calling StartAutoTick(), a separate
 thread will spawn, automatically calling Tick() continuously until PauseAutoTick() or StopAutoTick() is called.
 
+By default, the auto-tick thread ticks continuously, even when there's nothing to process. If the circuit's source components
+report when they are idle (see Component::IsIdle_()), StartAutoTick( AutoTickMode::IdleAware ) can be used instead. The auto-tick
+thread will then sleep while every source component is idle, and only wake up to tick again once a source signals new data (see
+Component::Wake_()), or Wake() is called.
+
+For offline batch processing of finite streams, RunToCompletion() ticks the circuit back-to-back until every sink (a component
+with connected inputs, whose outputs feed no other component) has seen end-of-stream (see Component::SetEndOfStream_()), then waits
+for every buffer in flight to finish processing before returning. Unconnected components are not sinks, so they don't hold up the
+run.
+
+<b>NOTE:</b> RunToCompletion() only returns once every sink has seen end-of-stream, so every sink must sit downstream of sources
+that eventually end their streams.
+
 The Circuit Optimize() method rearranges components such that they process in the most optimal order during Tick(). This
 optimization will occur automatically during the first Tick() proceeding any connection / disconnection, however, if you'd like to
 pre-order components before the next Tick() is processed, you can call Optimize() manually.
+
+<b>PERFORMANCE TIP:</b> Circuits of many thousands of components are optimized via an iterative, frontier-based topological sort
+that levelizes components across all available hardware threads. Circuits containing feedback loops can't be levelized this way,
+and fall back to the (single-threaded) recursive scan.
+
+By default, a multi-threaded circuit (see SetThreadCount()) distributes its components across threads in a round-robin fashion,
+synchronizing every wire that crosses threads. When a circuit holds several disconnected subgraphs ("islands"), calling
+SetScheduling( Scheduling::Islands ) instead assigns whole islands to threads, balanced by component count. Each thread then ticks
+its islands in series, so no wire is synchronized across threads. Tick() still waits for every thread it resumes though, so each
+call advances every island by exactly one tick, and the most heavily loaded thread sets the pace for the rest. GetIslandTickCount()
+reports how many ticks each island has completed (E.g. to follow a tick still under way).
+
+For a connected circuit, SetScheduling( Scheduling::Partitioned ) assigns components to threads with a graph partitioner instead:
+each component is placed with the components it's wired to wherever thread loads allow, balanced by cost (measured cycles where
+hardware performance counters are enabled, or component count otherwise). Outputs whose wires all stay on their thread then skip
+readiness synchronization altogether. GetCrossThreadWireCount() reports how many wires cross threads under the current schedule.
+
+Components that only need to process every Nth tick (E.g. control-rate components in an audio circuit) can be assigned a rate
+divisor via SetRateDivisor(). A component with a rate divisor of N processes on every Nth circuit tick only, and its off-rate
+ticks are skipped outright (no bus clearing, no wire traversal). Wires between components of different rates "hold" their
+values: each tick, the receiving component gets a copy of the latest output the sending component produced on or before that tick.
+Apply the same divisor across a subgraph to have it process every Nth tick as a whole. (In multi-buffered / multi-threaded
+circuits, a held value may be one the sending component produced for a tick still in flight.)
+
+To refresh just a part of a large circuit (E.g. a single meter), call TickSubgraph() with the components whose outputs are needed.
+Only those components and the components upstream of them are ticked (in an order that is computed once and cached until the
+circuit's wiring changes), while the rest of the circuit is left untouched.
+
+Components may request changes to their IO counts at runtime (see Component::RequestInputCount_()). Rather than pausing, the circuit
+applies these requests at the start of its next Tick(), once every buffer in flight has finished its tick, touching only the
+components that made requests.
+
+To predict how a circuit would scale before committing to a buffer / thread count (or hardware), call Analyze() with the cost of
+each component (indexed by component handle). If no costs are given, the cycles counted by each component's hardware performance
+counters are used (see SetPerfCountersEnabled()), or a unit cost where those are unavailable. The returned Analyzer reports the
+circuit's critical path and parallelism, and simulates its schedule for any buffer and thread count.
+
+To protect a host from components emitting ever-larger payloads (multiplied by the buffer count), a MemoryBudget can be assigned
+to a circuit via SetMemoryBudget(). Every component then accounts the payloads of its outputs against the budget (once per wire,
+counting fan-out copies), and the budget's policy decides what happens once it's exceeded: throttle the auto-tick, drop new
+payloads at the outputs producing them, or just call back (see MemoryBudget). A budget can be shared between several circuits to
+cap their combined usage. NOTE: Payloads are measured via SignalBus size hooks, so value types without a registered hook (see
+SignalBus::SetSizeHook()) are invisible to the budget.
+
+Per-wire transfer statistics (see Component::GetTransferStats()) and hardware performance counters (see
+Component::GetPerfCounts()) can be enabled for every component in the circuit via SetTransferStatsEnabled() and
+SetPerfCountersEnabled() respectively.
 */
 
 class Circuit final
@@ -75,38 +152,88 @@ public:
     Circuit( const Circuit& ) = delete;
     Circuit& operator=( const Circuit& ) = delete;
 
+    enum class Scheduling
+    {
+        Stride,
+        Islands,
+        Partitioned
+    };
+
+    enum class AutoTickMode
+    {
+        Continuous,
+        IdleAware
+    };
+
     Circuit();
     ~Circuit();
 
     bool AddComponent( const Component::SPtr& component );
+    template <typename ComponentType>
+    bool AddComponent( const std::shared_ptr<ComponentType>& component );
 
     bool RemoveComponent( const Component::SPtr& component );
+    bool RemoveComponent( int componentHandle );
     void RemoveAllComponents();
 
     int GetComponentCount() const;
 
+    int GetComponentHandle( const Component::SPtr& component ) const;
+    Component::SPtr GetComponent( int componentHandle ) const;
+
     bool ConnectOutToIn( const Component::SPtr& fromComponent, int fromOutput, const Component::SPtr& toComponent, int toInput );
+    bool ConnectOutToIn( int fromComponentHandle, int fromOutput, int toComponentHandle, int toInput );
 
     bool DisconnectComponent( const Component::SPtr& component );
+    bool DisconnectComponent( int componentHandle );
     void DisconnectAllComponents();
 
     void SetBufferCount( int bufferCount );
     int GetBufferCount() const;
 
+    bool SetRateDivisor( const Component::SPtr& component, int rateDivisor );
+    bool SetRateDivisor( int componentHandle, int rateDivisor );
+
     void SetThreadCount( int threadCount );
     int GetThreadCount() const;
 
+    void SetScheduling( Scheduling scheduling );
+    Scheduling GetScheduling() const;
+
+    int GetIslandCount() const;
+    uint64_t GetIslandTickCount( int islandNo ) const;
+
+    int GetCrossThreadWireCount() const;
+
+    void SetTransferStatsEnabled( bool enabled );
+    void SetPerfCountersEnabled( bool enabled );
+
+    void SetMemoryBudget( const std::shared_ptr<MemoryBudget>& memoryBudget );
+    std::shared_ptr<MemoryBudget> GetMemoryBudget() const;
+
     void Tick();
     void Sync();
 
-    void StartAutoTick();
+    void RunToCompletion();
+
+    Analyzer Analyze( const std::vector<double>& costs = {} );
+
+    bool TickSubgraph( const std::vector<Component::SPtr>& sinks );
+
+    void StartAutoTick( AutoTickMode mode = AutoTickMode::Continuous );
     void StopAutoTick();
     void PauseAutoTick();
     void ResumeAutoTick();
 
+    bool IsIdle() const;
+    void Wake();
+
     void Optimize();
 
 private:
+    using TickFunction = void ( * )( DSPatch::Component*, int );
+    using TickPlan = std::vector<std::pair<TickFunction, DSPatch::Component*>>;  // see _PlanTicks()
+
     class AutoTickThread final
     {
     public:
@@ -120,8 +247,10 @@ private:
             Stop();
         }
 
-        inline void Start( DSPatch::Circuit* circuit )
+        inline void Start( DSPatch::Circuit* circuit, AutoTickMode mode )
         {
+            _mode = mode;
+
             if ( !_stopped )
             {
                 Resume();
@@ -141,6 +270,8 @@ private:
         {
             _stop = true;
 
+            Wake();
+
             if ( _thread.joinable() )
             {
                 _thread.join();
@@ -153,6 +284,7 @@ private:
             {
                 std::unique_lock<std::mutex> lock( _resumeMutex );
                 _pause = true;
+                Wake();
                 _pauseCondt.wait( lock );  // wait for pause
             }
         }
@@ -167,14 +299,54 @@ private:
             }
         }
 
+        inline void Wake()
+        {
+            {
+                std::lock_guard<std::mutex> lock( _wakeMutex );
+                _woken = true;
+            }
+            _wakeCondt.notify_all();
+        }
+
     private:
+        inline bool _WaitForData()
+        {
+            // You might be thinking: Why check IsIdle() with _wakeMutex locked?
+
+            // Sources signal new data by first making it available, then calling Wake(), which sets
+            // _woken under this same mutex. So if a source's data arrives after we've checked it, the
+            // wake can't land until we're already waiting on _wakeCondt, and can never be missed.
+
+            std::unique_lock<std::mutex> lock( _wakeMutex );
+
+            while ( !_woken && !_stop && !_pause && _circuit->IsIdle() )
+            {
+                _wakeCondt.wait( lock );  // wait for data
+            }
+
+            _woken = false;
+
+            return !_stop && !_pause;
+        }
+
         inline void _Run()
         {
             if ( _circuit )
             {
                 while ( !_stop )
                 {
-                    _circuit->Tick();
+                    if ( _mode == AutoTickMode::Continuous || _WaitForData() )
+                    {
+                        _circuit->Tick();
+                    }
+
+                    // slow down while over a throttling memory budget (see Circuit::SetMemoryBudget())
+                    auto& memoryBudget = _circuit->_memoryBudget;
+                    if ( memoryBudget && memoryBudget->GetPolicy() == MemoryBudget::Policy::Throttle &&
+                         memoryBudget->IsExceeded() )
+                    {
+                        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+                    }
 
                     if ( _pause )
                     {
@@ -191,12 +363,14 @@ private:
 
         std::thread _thread;
         DSPatch::Circuit* _circuit = nullptr;
+        AutoTickMode _mode = AutoTickMode::Continuous;
         int pauseCount = 0;
         bool _stop = false;
         bool _pause = false;
         bool _stopped = true;
-        std::mutex _resumeMutex;
-        std::condition_variable _resumeCondt, _pauseCondt;
+        bool _woken = false;
+        std::mutex _resumeMutex, _wakeMutex;
+        std::condition_variable _resumeCondt, _pauseCondt, _wakeCondt;
     };
 
     class CircuitThread final
@@ -217,9 +391,9 @@ private:
             Stop();
         }
 
-        inline void Start( std::vector<DSPatch::Component*>* components, int bufferNo )
+        inline void Start( const TickPlan* tickPlan, int bufferNo )
         {
-            _components = components;
+            _tickPlan = tickPlan;
             _bufferNo = bufferNo;
 
             _stop = false;
@@ -263,6 +437,16 @@ private:
             Resume();
         }
 
+        inline void Run( const std::function<void()>& job )
+        {
+            // run job once in place of a tick (see Circuit::_ParallelFor())
+            {
+                std::lock_guard<std::mutex> lock( _syncMutex );
+                _job = &job;
+            }
+            Resume();
+        }
+
     private:
         inline void _Run()
         {
@@ -274,7 +458,7 @@ private:
             pthread_setschedparam( pthread_self(), SCHED_RR, &sch_params );
 #endif
 
-            if ( _components )
+            if ( _tickPlan )
             {
                 while ( !_stop )
                 {
@@ -286,6 +470,13 @@ private:
                         _resumeCondt.wait( lock );  // wait for resume
                     }
 
+                    if ( _job )
+                    {
+                        ( *_job )();
+                        _job = nullptr;
+                        continue;
+                    }
+
                     // cppcheck-suppress knownConditionTrueFalse
                     if ( !_stop )
                     {
@@ -298,9 +489,9 @@ private:
 
                         // E.g. 1,2,3 and 1,2,3. Not 1,2,3 and 2,3,1,2,3.
 
-                        for ( auto component : *_components )
+                        for ( const auto& tick : *_tickPlan )
                         {
-                            component->Tick( _bufferNo );
+                            tick.first( tick.second, _bufferNo );
                         }
                     }
                 }
@@ -308,7 +499,8 @@ private:
         }
 
         std::thread _thread;
-        std::vector<DSPatch::Component*>* _components = nullptr;
+        const TickPlan* _tickPlan = nullptr;
+        const std::function<void()>* _job = nullptr;
         int _bufferNo = 0;
         bool _stop = false;
         bool _gotSync = false;
@@ -334,9 +526,9 @@ private:
             Stop();
         }
 
-        inline void Start( std::vector<DSPatch::Component*>* components, int bufferNo, int threadNo, int threadCount )
+        inline void Start( DSPatch::Circuit* circuit, int bufferNo, int threadNo, int threadCount )
         {
-            _components = components;
+            _circuit = circuit;
             _bufferNo = bufferNo;
             _threadNo = threadNo;
             _threadCount = threadCount;
@@ -376,6 +568,16 @@ private:
             std::this_thread::yield();
         }
 
+        inline void Run( const std::function<void()>& job )
+        {
+            // run job once in place of a tick (see Circuit::_ParallelFor())
+            {
+                std::lock_guard<std::mutex> lock( _syncMutex );
+                _job = &job;
+            }
+            Resume();
+        }
+
     private:
         inline void _Run()
         {
@@ -387,7 +589,7 @@ private:
             pthread_setschedparam( pthread_self(), SCHED_RR, &sch_params );
 #endif
 
-            if ( _components )
+            if ( _circuit )
             {
                 while ( !_stop )
                 {
@@ -400,11 +602,56 @@ private:
                     }
 
                     // cppcheck-suppress knownConditionTrueFalse
-                    if ( !_stop )
+                    if ( _stop )
                     {
-                        for ( auto it = _components->begin() + _threadNo; it < _components->end(); it += _threadCount )
+                        continue;
+                    }
+
+                    if ( _job )
+                    {
+                        ( *_job )();
+                        _job = nullptr;
+                        continue;
+                    }
+
+                    // You might be thinking: Why wait for Tick() to finish resuming our sibling threads?
+
+                    // Because we run at a higher priority than the thread calling Tick(), and spin on wires from our
+                    // siblings. Where cores are scarce (E.g. a single core host), a thread resumed ahead of its siblings
+                    // would otherwise preempt Tick() and spin on a sibling that Tick() now never gets to resume. Blocking
+                    // on this mutex instead hands the core back until every sibling has been resumed.
+
+                    {
+                        std::lock_guard<std::mutex> lock( _circuit->_resumeMutex );
+                    }
+
+                    if ( _circuit->_scheduling == Scheduling::Partitioned )
+                    {
+                        for ( const auto& tick : _circuit->_threadTickPlans[_threadNo] )
+                        {
+                            tick.first( tick.second, _bufferNo );
+                        }
+                    }
+                    else if ( _circuit->_scheduling == Scheduling::Islands )
+                    {
+                        // islands share no wires, so each can be ticked in series without waiting on other threads
+                        for ( auto islandNo : _circuit->_threadIslands[_threadNo] )
+                        {
+                            for ( const auto& tick : _circuit->_islandTickPlans[islandNo] )
+                            {
+                                tick.first( tick.second, _bufferNo );
+                            }
+
+                            _circuit->_islandTickCounts[islandNo].fetch_add( 1, std::memory_order_release );
+                        }
+                    }
+                    else
+                    {
+                        auto& tickPlan = _circuit->_tickPlanParallel;
+
+                        for ( auto it = tickPlan.begin() + _threadNo; it < tickPlan.end(); it += _threadCount )
                         {
-                            ( *it )->TickParallel( _bufferNo );
+                            it->first( it->second, _bufferNo );
                         }
                     }
                 }
@@ -412,7 +659,8 @@ private:
         }
 
         std::thread _thread;
-        std::vector<DSPatch::Component*>* _components = nullptr;
+        DSPatch::Circuit* _circuit = nullptr;
+        const std::function<void()>* _job = nullptr;
         int _bufferNo = 0;
         int _threadNo = 0;
         int _threadCount = 0;
@@ -422,23 +670,75 @@ private:
         std::condition_variable _resumeCondt, _syncCondt;
     };
 
+    void _RequestIO( DSPatch::Component* component );
+    void _ApplyIORequests();
+
+    bool _AddComponent( const Component::SPtr& component, TickFunction tick, TickFunction tickParallel );
+
     void _Optimize();
+    bool _OptimizeLevels();
+    void _OptimizeIslands();
+    void _OptimizePartitions();
+
+    TickPlan _PlanTicks( const std::vector<DSPatch::Component*>& components, bool parallel ) const;
+
+    static double _MeasuredCost( DSPatch::Component* component );
+
+    template <typename Callback>
+    void _ParallelFor( int count, int workerCount, Callback&& callback );
+
+    // circuits of this many components are levelized rather than Scan()ed (see _OptimizeLevels()). This bounds Scan()'s
+    // recursion (one frame per component along the longest path) to a few thousand frames, well within any thread's stack,
+    // while keeping smaller circuits on Scan(), which orders a circuit roughly twice as fast as levelizing on a single thread
+    static constexpr int _levelizeMinComponents = 4096;
+
+    // the fewest components worth handing to another thread in _ParallelFor(): walking a component's wires takes well under
+    // a microsecond, while waking a circuit thread takes a few, so smaller chunks are quicker to process where they are
+    static constexpr int _parallelForMinChunk = 256;
 
     int _bufferCount = 0;
     int _threadCount = 0;
     int _currentBuffer = 0;
+    uint64_t _tickCount = 0;
 
     AutoTickThread _autoTickThread;
 
-    std::set<DSPatch::Component::SPtr> _componentsSet;
+    std::vector<DSPatch::Component::SPtr> _componentSlots;  // component per handle (nullptr if free)
+    std::vector<std::pair<TickFunction, TickFunction>> _componentTicks;  // Tick() and TickParallel() functions per handle
+    std::vector<int> _freeComponentSlots;
+    std::unordered_map<DSPatch::Component*, int> _componentHandles;
 
     std::vector<DSPatch::Component*> _components;
     std::vector<DSPatch::Component*> _componentsParallel;
+    std::vector<DSPatch::Component*> _sourceComponents;
+
+    TickPlan _tickPlan;          // _components, ticked in series
+    TickPlan _tickPlanParallel;  // _componentsParallel, ticked in parallel
+
+    std::mutex _ioRequestMutex;
+    std::vector<DSPatch::Component*> _ioRequests;
+    std::atomic<bool> _hasIORequests = false;
+
+    std::map<std::vector<DSPatch::Component*>, std::vector<DSPatch::Component*>> _subgraphs;  // subgraph per set of sinks
+
+    Scheduling _scheduling = Scheduling::Stride;
+    std::vector<std::vector<DSPatch::Component*>> _islands;
+    std::vector<std::vector<int>> _threadIslands;  // island numbers per thread
+    std::vector<std::atomic<uint64_t>> _islandTickCounts;
+    std::vector<std::vector<DSPatch::Component*>> _threadComponents;  // components per thread (partitioned)
+    std::vector<TickPlan> _islandTickPlans;
+    std::vector<TickPlan> _threadTickPlans;
+    int _crossThreadWireCount = 0;
 
     std::vector<CircuitThread> _circuitThreads;
     std::vector<std::vector<CircuitThreadParallel>> _circuitThreadsParallel;
+    std::mutex _resumeMutex;  // held by Tick() while it resumes a buffer's parallel threads (see CircuitThreadParallel::_Run())
 
     bool _circuitDirty = false;
+    bool _transferStatsEnabled = false;
+    bool _perfCountersEnabled = false;
+
+    std::shared_ptr<MemoryBudget> _memoryBudget;
 };
 
 inline Circuit::Circuit() = default;
@@ -447,52 +747,152 @@ inline Circuit::~Circuit()
 {
     StopAutoTick();
     DisconnectAllComponents();
+
+    // our components may outlive us (E.g. an Injector still held by its producer), so must no longer call back into us
+    for ( const auto& component : _componentSlots )
+    {
+        if ( component )
+        {
+            component->SetWakeCallback( nullptr );
+            component->SetIORequestCallback( nullptr );
+        }
+    }
 }
 
 inline bool Circuit::AddComponent( const Component::SPtr& component )
 {
-    if ( !component || _componentsSet.find( component ) != _componentsSet.end() )
+    return _AddComponent( component, &Component::TickAs<Component>, &Component::TickParallelAs<Component> );
+}
+
+template <typename ComponentType>
+inline bool Circuit::AddComponent( const std::shared_ptr<ComponentType>& component )
+{
+    // You might be thinking: Why not just tick every component via Component::Tick()?
+
+    // Component::Tick() can only reach Process_() through the vtable. Tick functions instantiated for
+    // the class the component was added as instead call a final class's Process_() directly, and
+    // give each class its own call site in the circuit's tick plans (see _PlanTicks()).
+
+    return _AddComponent( component, &Component::TickAs<ComponentType>, &Component::TickParallelAs<ComponentType> );
+}
+
+inline bool Circuit::_AddComponent( const Component::SPtr& component, TickFunction tick, TickFunction tickParallel )
+{
+    if ( !component || _componentHandles.find( component.get() ) != _componentHandles.end() )
     {
         return false;
     }
 
-    // components within the circuit need to have as many buffers as there are threads in the circuit
-    component->SetBufferCount( _bufferCount, _currentBuffer );
+    if ( _transferStatsEnabled )
+    {
+        component->SetTransferStatsEnabled( true );
+    }
+
+    if ( _perfCountersEnabled )
+    {
+        component->SetPerfCountersEnabled( true );
+    }
+
+    if ( _memoryBudget )
+    {
+        component->SetMemoryBudget( _memoryBudget );
+    }
+
+    component->SetWakeCallback( [this] { Wake(); } );
+    component->SetIORequestCallback( [this, c = component.get()] { _RequestIO( c ); } );
 
     PauseAutoTick();
+    // components within the circuit need to have as many buffers as there are threads in the circuit
+    // (set while paused, so that the component starts on the buffer the circuit is about to tick)
+    component->SetBufferCount( _bufferCount, _currentBuffer, _tickCount );
     _components.emplace_back( component.get() );
     _componentsParallel.emplace_back( component.get() );
-    ResumeAutoTick();
+    _tickPlan.emplace_back( tick, component.get() );
+    _tickPlanParallel.emplace_back( tickParallel, component.get() );
+    if ( component->GetInputCount() == 0 )
+    {
+        _sourceComponents.emplace_back( component.get() );
+    }
+    if ( _scheduling != Scheduling::Stride )
+    {
+        _circuitDirty = true;  // new component needs assigning to a thread
+    }
+
+    // recycle a free slot if there is one
+    // (also while paused, as _Optimize() looks up the handles of components in _components)
+    int componentHandle;
+    if ( !_freeComponentSlots.empty() )
+    {
+        componentHandle = _freeComponentSlots.back();
+        _freeComponentSlots.pop_back();
+        _componentSlots[componentHandle] = component;
+        _componentTicks[componentHandle] = { tick, tickParallel };
+    }
+    else
+    {
+        componentHandle = (int)_componentSlots.size();
+        _componentSlots.emplace_back( component );
+        _componentTicks.emplace_back( tick, tickParallel );
+    }
 
-    _componentsSet.emplace( component );
+    _componentHandles.emplace( component.get(), componentHandle );
+    ResumeAutoTick();
 
     return true;
 }
 
 inline bool Circuit::RemoveComponent( const Component::SPtr& component )
 {
-    if ( _componentsSet.find( component ) == _componentsSet.end() )
+    return RemoveComponent( GetComponentHandle( component ) );
+}
+
+inline bool Circuit::RemoveComponent( int componentHandle )
+{
+    auto component = GetComponent( componentHandle );
+
+    if ( !component )
     {
         return false;
     }
 
     auto findFn = [&component]( auto comp ) { return comp == component.get(); };
 
+    // find the component while paused (an auto-tick may otherwise reorder _components under us in _Optimize())
+    PauseAutoTick();
+
     if ( auto it = std::find_if( _components.begin(), _components.end(), findFn ); it != _components.end() )
     {
-        PauseAutoTick();
-
-        DisconnectComponent( component );
+        DisconnectComponent( componentHandle );
 
         _components.erase( it );
+        _sourceComponents.erase( std::remove( _sourceComponents.begin(), _sourceComponents.end(), component.get() ),
+                                 _sourceComponents.end() );
+
+        _componentHandles.erase( component.get() );
+        _componentSlots[componentHandle] = nullptr;
+        _freeComponentSlots.emplace_back( componentHandle );
 
         ResumeAutoTick();
 
-        _componentsSet.erase( component );
+        component->SetWakeCallback( nullptr );
+        component->SetIORequestCallback( nullptr );
+        component->SetMemoryBudget( nullptr );
+
+        for ( int i = 0; i < component->GetOutputCount(); ++i )
+        {
+            component->SetThreadLocalOutput( i, false );
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( _ioRequestMutex );
+            _ioRequests.erase( std::remove( _ioRequests.begin(), _ioRequests.end(), component.get() ), _ioRequests.end() );
+        }
 
         return true;
     }
 
+    ResumeAutoTick();
+
     return false;
 }
 
@@ -505,10 +905,37 @@ inline void Circuit::RemoveAllComponents()
 
     _components.clear();
     _componentsParallel.clear();
+    _sourceComponents.clear();
+    _tickPlan.clear();
+    _tickPlanParallel.clear();
+
+    auto componentSlots = std::move( _componentSlots );
+    _componentSlots.clear();
+    _componentTicks.clear();
+    _freeComponentSlots.clear();
+    _componentHandles.clear();
 
     ResumeAutoTick();
 
-    _componentsSet.clear();
+    for ( const auto& component : componentSlots )
+    {
+        if ( component )
+        {
+            component->SetWakeCallback( nullptr );
+            component->SetIORequestCallback( nullptr );
+            component->SetMemoryBudget( nullptr );
+
+            for ( int i = 0; i < component->GetOutputCount(); ++i )
+            {
+                component->SetThreadLocalOutput( i, false );
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( _ioRequestMutex );
+        _ioRequests.clear();
+    }
 }
 
 inline int Circuit::GetComponentCount() const
@@ -516,13 +943,38 @@ inline int Circuit::GetComponentCount() const
     return (int)_components.size();
 }
 
+inline int Circuit::GetComponentHandle( const Component::SPtr& component ) const
+{
+    if ( auto it = _componentHandles.find( component.get() ); it != _componentHandles.end() )
+    {
+        return it->second;
+    }
+    return -1;
+}
+
+inline Component::SPtr Circuit::GetComponent( int componentHandle ) const
+{
+    if ( componentHandle < 0 || componentHandle >= (int)_componentSlots.size() )
+    {
+        return nullptr;
+    }
+    return _componentSlots[componentHandle];
+}
+
 inline bool Circuit::ConnectOutToIn( const Component::SPtr& fromComponent,
                                      int fromOutput,
                                      const Component::SPtr& toComponent,
                                      int toInput )
 {
-    if ( _componentsSet.find( fromComponent ) == _componentsSet.end() ||
-         _componentsSet.find( toComponent ) == _componentsSet.end() )
+    return ConnectOutToIn( GetComponentHandle( fromComponent ), fromOutput, GetComponentHandle( toComponent ), toInput );
+}
+
+inline bool Circuit::ConnectOutToIn( int fromComponentHandle, int fromOutput, int toComponentHandle, int toInput )
+{
+    auto fromComponent = GetComponent( fromComponentHandle );
+    auto toComponent = GetComponent( toComponentHandle );
+
+    if ( !fromComponent || !toComponent )
     {
         return false;
     }
@@ -531,7 +983,10 @@ inline bool Circuit::ConnectOutToIn( const Component::SPtr& fromComponent,
 
     bool result = toComponent->ConnectInput( fromComponent, fromOutput, toInput );
 
-    _circuitDirty = result;
+    if ( result )
+    {
+        _circuitDirty = true;
+    }
 
     ResumeAutoTick();
 
@@ -540,7 +995,14 @@ inline bool Circuit::ConnectOutToIn( const Component::SPtr& fromComponent,
 
 inline bool Circuit::DisconnectComponent( const Component::SPtr& component )
 {
-    if ( _componentsSet.find( component ) == _componentsSet.end() )
+    return DisconnectComponent( GetComponentHandle( component ) );
+}
+
+inline bool Circuit::DisconnectComponent( int componentHandle )
+{
+    auto component = GetComponent( componentHandle );
+
+    if ( !component )
     {
         return false;
     }
@@ -571,6 +1033,8 @@ inline void Circuit::DisconnectAllComponents()
         component->DisconnectAllInputs();
     }
 
+    _subgraphs.clear();
+
     ResumeAutoTick();
 }
 
@@ -599,7 +1063,7 @@ inline void Circuit::SetBufferCount( int bufferCount )
         // initialise and start all threads
         for ( int i = 0; i < _bufferCount; ++i )
         {
-            _circuitThreads[i].Start( &_components, i );
+            _circuitThreads[i].Start( &_tickPlan, i );
         }
     }
 
@@ -611,7 +1075,7 @@ inline void Circuit::SetBufferCount( int bufferCount )
     // set all components to the new buffer count
     for ( auto component : _components )
     {
-        component->SetBufferCount( _bufferCount, _currentBuffer );
+        component->SetBufferCount( _bufferCount, _currentBuffer, _tickCount );
     }
 
     ResumeAutoTick();
@@ -622,11 +1086,40 @@ inline int Circuit::GetBufferCount() const
     return _bufferCount;
 }
 
+inline bool Circuit::SetRateDivisor( const Component::SPtr& component, int rateDivisor )
+{
+    return SetRateDivisor( GetComponentHandle( component ), rateDivisor );
+}
+
+inline bool Circuit::SetRateDivisor( int componentHandle, int rateDivisor )
+{
+    auto component = GetComponent( componentHandle );
+
+    if ( !component )
+    {
+        return false;
+    }
+
+    PauseAutoTick();
+
+    component->SetRateDivisor( rateDivisor );
+
+    // wires to and from the component may now cross rates (or no longer do)
+    for ( auto c : _components )
+    {
+        c->UpdateHeldInputs();
+    }
+
+    ResumeAutoTick();
+
+    return true;
+}
+
 inline void Circuit::SetThreadCount( int threadCount )
 {
     PauseAutoTick();
 
-    if ( _threadCount == 0 && threadCount != 0 )
+    if ( ( _threadCount == 0 && threadCount != 0 ) || ( _scheduling != Scheduling::Stride && _threadCount != threadCount ) )
     {
         _circuitDirty = true;
     }
@@ -663,7 +1156,7 @@ inline void Circuit::SetThreadCount( int threadCount )
             int j = 0;
             for ( auto& circuitThread : circuitThreads )
             {
-                circuitThread.Start( &_componentsParallel, i, j++, _threadCount );
+                circuitThread.Start( this, i, j++, _threadCount );
             }
             ++i;
         }
@@ -678,48 +1171,181 @@ inline int Circuit::GetThreadCount() const
     return _threadCount;
 }
 
-inline void Circuit::Tick()
+inline void Circuit::SetScheduling( Scheduling scheduling )
 {
-    if ( _circuitDirty )
+    if ( scheduling == _scheduling )
     {
-        _Optimize();
+        return;
     }
 
-    // process in a single thread if this circuit has no threads
-    // =========================================================
-    if ( _bufferCount == 0 && _threadCount == 0 )
-    {
-        // tick all internal components
-        for ( auto component : _components )
-        {
-            component->Tick( 0 );
-        }
+    PauseAutoTick();
 
-        return;
+    _scheduling = scheduling;
+    _circuitDirty = true;
+
+    ResumeAutoTick();
+}
+
+// cppcheck-suppress unusedFunction
+inline Circuit::Scheduling Circuit::GetScheduling() const
+{
+    return _scheduling;
+}
+
+inline int Circuit::GetIslandCount() const
+{
+    return (int)_islands.size();
+}
+
+inline uint64_t Circuit::GetIslandTickCount( int islandNo ) const
+{
+    if ( islandNo < 0 || islandNo >= (int)_islandTickCounts.size() )
+    {
+        return 0;
     }
-    // process in multiple threads if this circuit has threads
-    // =======================================================
-    else if ( _threadCount != 0 )
+    return _islandTickCounts[islandNo].load( std::memory_order_acquire );
+}
+
+inline int Circuit::GetCrossThreadWireCount() const
+{
+    // (only partitioning needs to know which wires cross threads, so round-robin schedules are counted here, on demand)
+    if ( _scheduling != Scheduling::Stride || _threadCount == 0 )
     {
-        auto& circuitThreads = _circuitThreadsParallel[_currentBuffer];
+        return _crossThreadWireCount;
+    }
 
-        for ( auto& circuitThread : circuitThreads )
-        {
-            circuitThread.Sync();
-        }
-        for ( auto& circuitThread : circuitThreads )
+    // (_componentsParallel still holds components removed since the last optimize, which may no longer exist, so skip those)
+    std::unordered_map<DSPatch::Component*, int> positions;
+    positions.reserve( _componentsParallel.size() );
+    for ( int i = 0; i < (int)_componentsParallel.size(); ++i )
+    {
+        if ( _componentHandles.find( _componentsParallel[i] ) != _componentHandles.end() )
         {
-            circuitThread.Resume();
+            positions.emplace( _componentsParallel[i], i );
         }
     }
-    else
-    {
-        _circuitThreads[_currentBuffer].SyncAndResume();  // sync and resume thread x
-    }
 
-    if ( _bufferCount != 0 && ++_currentBuffer == _bufferCount )
+    int crossThreadWireCount = 0;
+    for ( const auto& position : positions )
     {
-        _currentBuffer = 0;
+        const int i = position.second;
+        position.first->ForEachInputWire( [&]( DSPatch::Component* fromComponent, int, int ) {
+            auto it = positions.find( fromComponent );
+            if ( it != positions.end() && it->second % _threadCount != i % _threadCount )
+            {
+                ++crossThreadWireCount;
+            }
+        } );
+    }
+
+    return crossThreadWireCount;
+}
+
+inline void Circuit::SetTransferStatsEnabled( bool enabled )
+{
+    PauseAutoTick();
+
+    _transferStatsEnabled = enabled;
+
+    for ( auto component : _components )
+    {
+        component->SetTransferStatsEnabled( enabled );
+    }
+
+    ResumeAutoTick();
+}
+
+inline void Circuit::SetPerfCountersEnabled( bool enabled )
+{
+    PauseAutoTick();
+
+    _perfCountersEnabled = enabled;
+
+    for ( auto component : _components )
+    {
+        component->SetPerfCountersEnabled( enabled );
+    }
+
+    ResumeAutoTick();
+}
+
+inline void Circuit::SetMemoryBudget( const std::shared_ptr<MemoryBudget>& memoryBudget )
+{
+    PauseAutoTick();
+
+    _memoryBudget = memoryBudget;
+
+    for ( auto component : _components )
+    {
+        component->SetMemoryBudget( memoryBudget );
+    }
+
+    ResumeAutoTick();
+}
+
+// cppcheck-suppress unusedFunction
+inline std::shared_ptr<MemoryBudget> Circuit::GetMemoryBudget() const
+{
+    return _memoryBudget;
+}
+
+inline void Circuit::Tick()
+{
+    if ( _hasIORequests.load( std::memory_order_acquire ) )
+    {
+        _ApplyIORequests();
+    }
+
+    if ( _circuitDirty )
+    {
+        _Optimize();
+    }
+
+    DSPATCH_PROBE( tick_begin, this, _currentBuffer );
+
+    ++_tickCount;
+
+    // process in a single thread if this circuit has no threads
+    // =========================================================
+    if ( _bufferCount == 0 && _threadCount == 0 )
+    {
+        // tick all internal components
+        for ( const auto& tick : _tickPlan )
+        {
+            tick.first( tick.second, 0 );
+        }
+
+        DSPATCH_PROBE( tick_end, this, 0 );
+
+        return;
+    }
+    // process in multiple threads if this circuit has threads
+    // =======================================================
+    else if ( _threadCount != 0 )
+    {
+        auto& circuitThreads = _circuitThreadsParallel[_currentBuffer];
+
+        for ( auto& circuitThread : circuitThreads )
+        {
+            circuitThread.Sync();
+        }
+
+        std::lock_guard<std::mutex> lock( _resumeMutex );
+        for ( auto& circuitThread : circuitThreads )
+        {
+            circuitThread.Resume();
+        }
+    }
+    else
+    {
+        _circuitThreads[_currentBuffer].SyncAndResume();  // sync and resume thread x
+    }
+
+    DSPATCH_PROBE( tick_end, this, _currentBuffer );
+
+    if ( _bufferCount != 0 && ++_currentBuffer == _bufferCount )
+    {
+        _currentBuffer = 0;
     }
 }
 
@@ -739,9 +1365,168 @@ inline void Circuit::Sync()
     }
 }
 
-inline void Circuit::StartAutoTick()
+// cppcheck-suppress unusedFunction
+inline void Circuit::RunToCompletion()
+{
+    PauseAutoTick();
+
+    if ( _circuitDirty )
+    {
+        _Optimize();
+    }
+
+    // find the sinks: components with inputs, whose outputs feed no other component
+    // (a component with no inputs, like a stray source, may never end its stream, so it can't hold up the run)
+    std::unordered_set<DSPatch::Component*> feedsOthers;
+    std::unordered_set<DSPatch::Component*> hasInputs;
+    feedsOthers.reserve( _components.size() );
+    hasInputs.reserve( _components.size() );
+
+    for ( auto component : _components )
+    {
+        component->ForEachInputWire( [&feedsOthers, &hasInputs, component]( DSPatch::Component* fromComponent, int, int ) {
+            feedsOthers.insert( fromComponent );
+            hasInputs.insert( component );
+        } );
+    }
+
+    std::vector<DSPatch::Component*> sinks;
+
+    for ( auto component : _components )
+    {
+        if ( hasInputs.find( component ) != hasInputs.end() && feedsOthers.find( component ) == feedsOthers.end() )
+        {
+            sinks.emplace_back( component );
+        }
+    }
+
+    if ( !sinks.empty() )
+    {
+        while ( true )
+        {
+            // wait for the buffer we're about to tick to finish its previous tick, so its EOS flags can be read
+            if ( _threadCount != 0 )
+            {
+                for ( auto& circuitThread : _circuitThreadsParallel[_currentBuffer] )
+                {
+                    circuitThread.Sync();
+                }
+            }
+            else if ( _bufferCount != 0 )
+            {
+                _circuitThreads[_currentBuffer].Sync();
+            }
+
+            const int bufferNo = _currentBuffer;
+
+            if ( std::all_of( sinks.begin(), sinks.end(), [bufferNo]( auto sink ) { return sink->IsEndOfStream( bufferNo ); } ) )
+            {
+                break;
+            }
+
+            Tick();
+        }
+    }
+
+    // flush all buffers still in flight
+    Sync();
+
+    ResumeAutoTick();
+}
+
+inline Analyzer Circuit::Analyze( const std::vector<double>& costs )
+{
+    PauseAutoTick();
+
+    if ( _circuitDirty )
+    {
+        _Optimize();
+    }
+
+    std::unordered_map<DSPatch::Component*, int> nodeIndices;
+    nodeIndices.reserve( _components.size() );
+
+    std::vector<Analyzer::Node> nodes( _components.size() );
+
+    // series order is topological (bar feedback), just as Analyzer expects
+    for ( int i = 0; i < (int)_components.size(); ++i )
+    {
+        auto component = _components[i];
+        auto& node = nodes[i];
+
+        nodeIndices[component] = i;
+
+        node.id = _componentHandles[component];
+        node.inOrder = component->GetProcessOrder() == Component::ProcessOrder::InOrder;
+        node.cost = node.id < (int)costs.size() ? costs[node.id] : _MeasuredCost( component );
+    }
+
+    for ( int i = 0; i < (int)_components.size(); ++i )
+    {
+        _components[i]->ForEachInputWire( [&nodes, &nodeIndices, i]( DSPatch::Component* fromComponent, int, int ) {
+            nodes[i].inputs.emplace_back( nodeIndices[fromComponent] );
+        } );
+    }
+
+    ResumeAutoTick();
+
+    return Analyzer( std::move( nodes ) );
+}
+
+inline bool Circuit::TickSubgraph( const std::vector<Component::SPtr>& sinks )
+{
+    std::vector<DSPatch::Component*> sinkKey;
+    sinkKey.reserve( sinks.size() );
+
+    for ( const auto& sink : sinks )
+    {
+        if ( _componentHandles.find( sink.get() ) == _componentHandles.end() )
+        {
+            return false;
+        }
+        sinkKey.emplace_back( sink.get() );
+    }
+
+    PauseAutoTick();
+
+    if ( _circuitDirty )
+    {
+        _Optimize();
+    }
+
+    auto it = _subgraphs.find( sinkKey );
+
+    if ( it == _subgraphs.end() )
+    {
+        // scan upstream from each sink for the optimal series order of the subgraph
+        std::vector<DSPatch::Component*> subgraph;
+
+        for ( auto sink : sinkKey )
+        {
+            sink->Scan( subgraph );
+        }
+        for ( auto component : subgraph )
+        {
+            component->EndScan();
+        }
+
+        it = _subgraphs.emplace( std::move( sinkKey ), std::move( subgraph ) ).first;
+    }
+
+    // tick all subgraph components
+    for ( auto component : it->second )
+    {
+        component->TickDetached( _currentBuffer );
+    }
+
+    ResumeAutoTick();
+
+    return true;
+}
+
+inline void Circuit::StartAutoTick( AutoTickMode mode )
 {
-    _autoTickThread.Start( this );
+    _autoTickThread.Start( this, mode );
 }
 
 inline void Circuit::StopAutoTick()
@@ -761,6 +1546,19 @@ inline void Circuit::ResumeAutoTick()
     _autoTickThread.Resume();
 }
 
+inline bool Circuit::IsIdle() const
+{
+    // a circuit is idle when it has sources, and every one of them is idle
+    return !_sourceComponents.empty() && std::all_of( _sourceComponents.begin(), _sourceComponents.end(), []( auto component ) {
+               return component->IsIdle();
+           } );
+}
+
+inline void Circuit::Wake()
+{
+    _autoTickThread.Wake();
+}
+
 inline void Circuit::Optimize()
 {
     if ( _circuitDirty )
@@ -771,9 +1569,82 @@ inline void Circuit::Optimize()
     }
 }
 
+inline void Circuit::_RequestIO( DSPatch::Component* component )
+{
+    std::lock_guard<std::mutex> lock( _ioRequestMutex );
+
+    if ( std::find( _ioRequests.begin(), _ioRequests.end(), component ) == _ioRequests.end() )
+    {
+        _ioRequests.emplace_back( component );
+    }
+
+    _hasIORequests.store( true, std::memory_order_release );
+}
+
+inline void Circuit::_ApplyIORequests()
+{
+    // You might be thinking: Why not just PauseAutoTick() here?
+
+    // This is called from Tick(), which may well be running on the auto-tick thread itself. All we
+    // need is for every buffer in flight to finish its tick, so that no thread is touching the IO of
+    // the requesting components. Everything else in the circuit is left as is.
+
+    Sync();
+
+    std::vector<DSPatch::Component*> ioRequests;
+
+    {
+        std::lock_guard<std::mutex> lock( _ioRequestMutex );
+        ioRequests.swap( _ioRequests );
+        _hasIORequests.store( false, std::memory_order_relaxed );
+    }
+
+    for ( auto component : ioRequests )
+    {
+        const auto inputCount = component->GetInputCount();
+        const auto outputCount = component->GetOutputCount();
+
+        component->ApplyIORequests();
+
+        if ( component->GetInputCount() < inputCount )
+        {
+            _circuitDirty = true;  // wires to removed inputs were disconnected
+        }
+
+        if ( component->GetOutputCount() < outputCount )
+        {
+            // disconnect wires from removed outputs
+            for ( auto toComponent : _components )
+            {
+                std::vector<int> toInputs;
+
+                toComponent->ForEachInputWire( [component, &toInputs]( DSPatch::Component* fromComponent, int fromOutput, int toInput ) {
+                    if ( fromComponent == component && fromOutput >= component->GetOutputCount() )
+                    {
+                        toInputs.emplace_back( toInput );
+                    }
+                } );
+
+                for ( auto toInput : toInputs )
+                {
+                    toComponent->DisconnectInput( toInput );
+                }
+            }
+
+            _circuitDirty = true;
+        }
+    }
+}
+
 inline void Circuit::_Optimize()
 {
+    DSPATCH_PROBE( optimize_begin, this, (int)_components.size() );
+
+    // levelize large circuits in parallel -> update _components and _componentsParallel
+    const bool levelized = (int)_components.size() >= _levelizeMinComponents && _OptimizeLevels();
+
     // scan for optimal series order -> update _components
+    if ( !levelized )
     {
         std::vector<DSPatch::Component*> orderedComponents;
         orderedComponents.reserve( _components.size() );
@@ -791,7 +1662,7 @@ inline void Circuit::_Optimize()
     }
 
     // scan for optimal parallel order -> update _componentsParallel
-    if ( _threadCount != 0 )
+    if ( !levelized && _threadCount != 0 )
     {
         std::vector<std::vector<DSPatch::Component*>> componentsMap;
         componentsMap.reserve( _components.size() );
@@ -814,8 +1685,513 @@ inline void Circuit::_Optimize()
         }
     }
 
+    // scan for disconnected islands -> update _islands and _threadIslands
+    if ( _scheduling == Scheduling::Islands )
+    {
+        _OptimizeIslands();
+    }
+    else
+    {
+        _islands.clear();
+        _threadIslands.clear();
+        _islandTickCounts.clear();
+    }
+
+    // partition components across threads -> update _threadComponents and thread-local outputs
+    if ( _scheduling == Scheduling::Partitioned && _threadCount != 0 )
+    {
+        _OptimizePartitions();
+    }
+    else if ( !_threadComponents.empty() )
+    {
+        // no longer partitioned, so no output is thread-local anymore
+        for ( const auto& threadComponents : _threadComponents )
+        {
+            for ( auto component : threadComponents )
+            {
+                for ( int i = 0; i < component->GetOutputCount(); ++i )
+                {
+                    component->SetThreadLocalOutput( i, false );
+                }
+            }
+        }
+
+        _threadComponents.clear();
+        _crossThreadWireCount = 0;
+    }
+
+    // build flat tick plans from the orders above -> update _tickPlan, _tickPlanParallel, _islandTickPlans and _threadTickPlans
+    _tickPlan = _PlanTicks( _components, false );
+    _tickPlanParallel = _threadCount != 0 ? _PlanTicks( _componentsParallel, true ) : TickPlan();
+
+    _islandTickPlans.clear();
+    for ( const auto& island : _islands )
+    {
+        _islandTickPlans.emplace_back( _PlanTicks( island, false ) );
+    }
+
+    _threadTickPlans.clear();
+    for ( const auto& threadComponents : _threadComponents )
+    {
+        _threadTickPlans.emplace_back( _PlanTicks( threadComponents, true ) );
+    }
+
+    // subgraphs need to be re-scanned
+    _subgraphs.clear();
+
     // clear _circuitDirty flag
     _circuitDirty = false;
+
+    DSPATCH_PROBE( optimize_end, this, (int)_components.size() );
+}
+
+inline bool Circuit::_OptimizeLevels()
+{
+    // You might be thinking: Why not just parallelize Scan()?
+
+    // Scan() is a recursive depth-first search, which is inherently sequential (and deep enough
+    // circuits can even overflow the stack). Instead, we count each component's input wires, then
+    // repeatedly peel off the "frontier" of components with no remaining unprocessed inputs. Every
+    // frontier is one level of the circuit (exactly what ScanParallel() computes), and each frontier
+    // can be processed by many threads at once, as the only shared state is an atomic counter per
+    // component.
+
+    const int componentCount = (int)_components.size();
+
+    // the circuit's own threads do the work (alongside this one), up to one per core
+    int threadCount = (int)_circuitThreads.size();
+    for ( const auto& circuitThreads : _circuitThreadsParallel )
+    {
+        threadCount += (int)circuitThreads.size();
+    }
+    const int workerCount = std::max( 1, std::min( threadCount + 1, (int)std::thread::hardware_concurrency() ) );
+
+    // map component handles to positions in _components
+    std::vector<int> positions( _componentSlots.size(), -1 );
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        positions[_componentHandles.find( _components[i] )->second] = i;
+    }
+
+    auto positionOf = [this, &positions]( DSPatch::Component* component ) {
+        auto it = _componentHandles.find( component );
+        return it == _componentHandles.end() ? -1 : positions[it->second];
+    };
+
+    // count input and output wires per component
+    std::vector<std::atomic<int>> inputCounts( componentCount );
+    std::vector<std::atomic<int>> outputCounts( componentCount );
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        outputCounts[i].store( 0, std::memory_order_relaxed );
+    }
+
+    _ParallelFor( componentCount, workerCount, [&]( int, int begin, int end ) {
+        for ( int i = begin; i < end; ++i )
+        {
+            int inputCount = 0;
+            _components[i]->ForEachInputWire( [&]( DSPatch::Component* fromComponent, int, int ) {
+                if ( auto from = positionOf( fromComponent ); from != -1 )
+                {
+                    ++inputCount;
+                    outputCounts[from].fetch_add( 1, std::memory_order_relaxed );
+                }
+            } );
+            inputCounts[i].store( inputCount, std::memory_order_relaxed );
+        }
+    } );
+
+    // lay out each component's outgoing wires contiguously
+    std::vector<int> outputOffsets( componentCount + 1, 0 );
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        outputOffsets[i + 1] = outputOffsets[i] + outputCounts[i].load( std::memory_order_relaxed );
+        outputCounts[i].store( outputOffsets[i], std::memory_order_relaxed );
+    }
+
+    std::vector<int> outputs( outputOffsets[componentCount] );
+
+    _ParallelFor( componentCount, workerCount, [&]( int, int begin, int end ) {
+        for ( int i = begin; i < end; ++i )
+        {
+            _components[i]->ForEachInputWire( [&]( DSPatch::Component* fromComponent, int, int ) {
+                if ( auto from = positionOf( fromComponent ); from != -1 )
+                {
+                    outputs[outputCounts[from].fetch_add( 1, std::memory_order_relaxed )] = i;
+                }
+            } );
+        }
+    } );
+
+    // the first frontier is every component without inputs
+    std::vector<int> frontier;
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        if ( inputCounts[i].load( std::memory_order_relaxed ) == 0 )
+        {
+            frontier.emplace_back( i );
+        }
+    }
+
+    std::vector<DSPatch::Component*> orderedComponents;
+    orderedComponents.reserve( componentCount );
+
+    std::vector<std::vector<int>> nextFrontiers( workerCount );
+
+    while ( !frontier.empty() )
+    {
+        // group components of the same class together (any order within a level is valid)
+        std::stable_sort( frontier.begin(), frontier.end(), [this]( int lhs, int rhs ) {
+            return typeid( *_components[lhs] ).before( typeid( *_components[rhs] ) );
+        } );
+
+        for ( auto i : frontier )
+        {
+            orderedComponents.emplace_back( _components[i] );
+        }
+
+        // release each frontier component's outgoing wires, collecting components left with none
+        _ParallelFor( (int)frontier.size(), workerCount, [&]( int workerNo, int begin, int end ) {
+            for ( int f = begin; f < end; ++f )
+            {
+                auto i = frontier[f];
+                for ( int o = outputOffsets[i]; o < outputOffsets[i + 1]; ++o )
+                {
+                    if ( inputCounts[outputs[o]].fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+                    {
+                        nextFrontiers[workerNo].emplace_back( outputs[o] );
+                    }
+                }
+            }
+        } );
+
+        frontier.clear();
+        for ( auto& nextFrontier : nextFrontiers )
+        {
+            frontier.insert( frontier.end(), nextFrontier.begin(), nextFrontier.end() );
+            nextFrontier.clear();
+        }
+    }
+
+    // components left over are part of a feedback loop
+    if ( (int)orderedComponents.size() != componentCount )
+    {
+        return false;
+    }
+
+    // levels are valid for both series and parallel processing
+    _components = std::move( orderedComponents );
+
+    if ( _threadCount != 0 )
+    {
+        _componentsParallel = _components;
+    }
+
+    return true;
+}
+
+template <typename Callback>
+inline void Circuit::_ParallelFor( int count, int workerCount, Callback&& callback )
+{
+    // callback( workerNo, begin, end )
+
+    // You might be thinking: Why borrow the circuit threads rather than spawn workers here?
+
+    // _OptimizeLevels() calls this once per level of the circuit, so spawning (and joining) threads
+    // each time would cost more than narrow levels take to process. The circuit threads are already
+    // running, and are all synced (idle) while the circuit is being optimized, so each can simply be
+    // resumed to run a chunk in place of a tick, then synced again.
+
+    workerCount = std::min( workerCount, ( count + _parallelForMinChunk - 1 ) / _parallelForMinChunk );
+
+    if ( workerCount <= 1 )
+    {
+        callback( 0, 0, count );
+        return;
+    }
+
+    const int chunkSize = ( count + workerCount - 1 ) / workerCount;
+
+    std::vector<std::function<void()>> jobs( workerCount );
+    for ( int workerNo = 1; workerNo < workerCount; ++workerNo )
+    {
+        jobs[workerNo] = [&callback, workerNo, chunkSize, count] {
+            callback( workerNo, workerNo * chunkSize, std::min( count, ( workerNo + 1 ) * chunkSize ) );
+        };
+    }
+
+    int workerNo = 1;
+    auto runJob = [&jobs, &workerNo, workerCount]( auto& circuitThread ) {
+        if ( workerNo < workerCount )
+        {
+            circuitThread.Sync();
+            circuitThread.Run( jobs[workerNo++] );
+        }
+    };
+
+    for ( auto& circuitThread : _circuitThreads )
+    {
+        runJob( circuitThread );
+    }
+    for ( auto& circuitThreads : _circuitThreadsParallel )
+    {
+        for ( auto& circuitThread : circuitThreads )
+        {
+            runJob( circuitThread );
+        }
+    }
+
+    callback( 0, 0, chunkSize );
+
+    Sync();
+}
+
+inline void Circuit::_OptimizeIslands()
+{
+    // find weakly-connected components (islands) via union-find over all wires (indexed by component handle)
+    std::vector<int> roots( _componentSlots.size() );
+    std::iota( roots.begin(), roots.end(), 0 );
+
+    auto findRoot = [&roots]( int i ) {
+        while ( roots[i] != i )
+        {
+            i = roots[i] = roots[roots[i]];
+        }
+        return i;
+    };
+
+    for ( const auto& componentHandle : _componentHandles )
+    {
+        componentHandle.first->ForEachInputWire( [&]( DSPatch::Component* fromComponent, int, int ) {
+            if ( auto it = _componentHandles.find( fromComponent ); it != _componentHandles.end() )
+            {
+                roots[findRoot( componentHandle.second )] = findRoot( it->second );
+            }
+        } );
+    }
+
+    // gather islands (in series order, as _components is already in series order)
+    std::vector<int> islandNos( _componentSlots.size(), -1 );
+    _islands.clear();
+    for ( auto component : _components )
+    {
+        auto& islandNo = islandNos[findRoot( _componentHandles[component] )];
+        if ( islandNo == -1 )
+        {
+            islandNo = (int)_islands.size();
+            _islands.emplace_back();
+        }
+        _islands[islandNo].emplace_back( component );
+    }
+
+    _islandTickCounts = std::vector<std::atomic<uint64_t>>( _islands.size() );
+    for ( auto& islandTickCount : _islandTickCounts )
+    {
+        islandTickCount.store( 0, std::memory_order_relaxed );
+    }
+
+    // assign largest islands first, each to the least loaded thread
+    std::vector<int> islandOrder( _islands.size() );
+    std::iota( islandOrder.begin(), islandOrder.end(), 0 );
+    std::stable_sort( islandOrder.begin(), islandOrder.end(), [this]( int lhs, int rhs ) {
+        return _islands[lhs].size() > _islands[rhs].size();
+    } );
+
+    _threadIslands.assign( std::max( _threadCount, 1 ), {} );
+    std::vector<size_t> threadLoads( _threadIslands.size(), 0 );
+
+    for ( auto islandNo : islandOrder )
+    {
+        auto threadNo = std::min_element( threadLoads.begin(), threadLoads.end() ) - threadLoads.begin();
+        _threadIslands[threadNo].emplace_back( islandNo );
+        threadLoads[threadNo] += _islands[islandNo].size();
+    }
+}
+
+inline void Circuit::_OptimizePartitions()
+{
+    _threadComponents.clear();
+    _crossThreadWireCount = 0;
+
+    const auto& components = _componentsParallel;
+    const int componentCount = (int)components.size();
+
+    // gather wires between positions in parallel order (which is also the order each thread ticks in)
+    struct Wire final
+    {
+        int from, fromOutput, to;
+    };
+
+    std::unordered_map<DSPatch::Component*, int> positions;
+    positions.reserve( componentCount );
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        positions.emplace( components[i], i );
+    }
+
+    std::vector<Wire> wires;
+    std::vector<std::vector<int>> neighbours( componentCount );
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        components[i]->ForEachInputWire( [&]( DSPatch::Component* fromComponent, int fromOutput, int ) {
+            auto it = positions.find( fromComponent );
+            if ( it == positions.end() )
+            {
+                return;  // wired from outside the circuit
+            }
+            const int from = it->second;
+            wires.push_back( { from, fromOutput, i } );
+            neighbours[from].emplace_back( i );
+            neighbours[i].emplace_back( from );
+        } );
+    }
+
+    // assign each component a thread
+    std::vector<int> threadNos( componentCount, 0 );
+
+    std::vector<double> costs( componentCount );
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        costs[i] = _MeasuredCost( components[i] );
+    }
+
+    // allow each thread up to its fair share of the total cost, plus enough slack to fit any one component
+    const double costLimit = std::accumulate( costs.begin(), costs.end(), 0.0 ) / _threadCount +
+                             ( costs.empty() ? 0.0 : *std::max_element( costs.begin(), costs.end() ) );
+
+    std::vector<double> threadCosts( _threadCount, 0.0 );
+    std::vector<int> affinities( _threadCount );
+
+    // pick the thread with the most wires to this component that still has room (least loaded on ties)
+    auto bestThread = [&]( int i, int exclude ) {
+        int best = -1;
+        for ( int t = 0; t < _threadCount; ++t )
+        {
+            if ( t == exclude || threadCosts[t] + costs[i] > costLimit )
+            {
+                continue;
+            }
+            if ( best == -1 || affinities[t] > affinities[best] ||
+                 ( affinities[t] == affinities[best] && threadCosts[t] < threadCosts[best] ) )
+            {
+                best = t;
+            }
+        }
+        return best;
+    };
+
+    auto countAffinities = [&]( int i, bool inputsOnly ) {
+        std::fill( affinities.begin(), affinities.end(), 0 );
+        for ( auto neighbour : neighbours[i] )
+        {
+            if ( !inputsOnly || neighbour < i )
+            {
+                ++affinities[threadNos[neighbour]];
+            }
+        }
+    };
+
+    // greedy pass: place components in order, next to their (already placed) inputs
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        countAffinities( i, true );
+
+        int threadNo = bestThread( i, -1 );
+        if ( threadNo == -1 )
+        {
+            threadNo = (int)( std::min_element( threadCosts.begin(), threadCosts.end() ) - threadCosts.begin() );
+        }
+
+        threadNos[i] = threadNo;
+        threadCosts[threadNo] += costs[i];
+    }
+
+    // refinement passes: move components to the thread most of their wires lead to, while it has room
+    for ( int pass = 0; pass < 4; ++pass )
+    {
+        bool moved = false;
+
+        for ( int i = 0; i < componentCount; ++i )
+        {
+            countAffinities( i, false );
+
+            const int threadNo = bestThread( i, threadNos[i] );
+            if ( threadNo != -1 && affinities[threadNo] > affinities[threadNos[i]] )
+            {
+                threadCosts[threadNos[i]] -= costs[i];
+                threadCosts[threadNo] += costs[i];
+                threadNos[i] = threadNo;
+                moved = true;
+            }
+        }
+
+        if ( !moved )
+        {
+            break;
+        }
+    }
+
+    _threadComponents.assign( _threadCount, {} );
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        _threadComponents[threadNos[i]].emplace_back( components[i] );
+    }
+
+    // an output is thread-local when all of its wires lead to components later on its own thread
+    std::vector<std::vector<char>> threadLocal( componentCount );
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        threadLocal[i].assign( components[i]->GetOutputCount(), 0 );
+    }
+    for ( const auto& wire : wires )
+    {
+        threadLocal[wire.from][wire.fromOutput] = 1;
+    }
+    for ( const auto& wire : wires )
+    {
+        if ( threadNos[wire.from] != threadNos[wire.to] )
+        {
+            ++_crossThreadWireCount;
+        }
+        if ( threadNos[wire.from] != threadNos[wire.to] || wire.to <= wire.from )
+        {
+            threadLocal[wire.from][wire.fromOutput] = 0;
+        }
+    }
+    for ( int i = 0; i < componentCount; ++i )
+    {
+        for ( int j = 0; j < (int)threadLocal[i].size(); ++j )
+        {
+            components[i]->SetThreadLocalOutput( j, threadLocal[i][j] != 0 );
+        }
+    }
+}
+
+inline Circuit::TickPlan Circuit::_PlanTicks( const std::vector<DSPatch::Component*>& components, bool parallel ) const
+{
+    // You might be thinking: Why copy tick orders into plans, rather than tick the components in them directly?
+
+    // Looking up each component's tick function (see AddComponent()) on every tick would cost as much
+    // as the virtual call it replaces. A plan pairs each component with its tick function up front, so
+    // a tick loop is a walk over one contiguous array, making one call per entry into code specific to
+    // that component's class.
+
+    TickPlan tickPlan;
+    tickPlan.reserve( components.size() );
+
+    for ( auto component : components )
+    {
+        const auto& ticks = _componentTicks[_componentHandles.find( component )->second];
+        tickPlan.emplace_back( parallel ? ticks.second : ticks.first, component );
+    }
+
+    return tickPlan;
+}
+
+inline double Circuit::_MeasuredCost( DSPatch::Component* component )
+{
+    const auto cycles = component->GetPerfCounts().cycles;
+    return cycles != 0 ? (double)cycles : 1.0;
 }
 
 }  // namespace DSPatch
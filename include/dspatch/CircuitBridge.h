@@ -0,0 +1,283 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#include "Component.h"
+#include "RingBuffer.h"
+
+#include <functional>
+#include <type_traits>
+
+namespace DSPatch
+{
+
+/// Lock-free wire between 2 circuits
+
+/**
+A CircuitBridge joins an output in one circuit to an input in another, where the 2 circuits tick independently (E.g. auto-ticking
+at different rates). A CircuitBridge provides 2 built-in components: a sender (GetSender()), that is added to the sending circuit
+and pushes each value it receives into a lock-free RingBuffer, and a receiver (GetReceiver()), that is added to the receiving
+circuit and pops one value from the ring per tick. Neither side ever locks or waits on the other, so both circuits stay fully
+decoupled.
+
+The behaviour of the receiver when the ring is empty on a tick (underflow) is configured via UnderflowPolicy:
+    - UnderflowPolicy::Drop - Output nothing for this tick.
+    - UnderflowPolicy::Repeat - Output a copy of the last value received (if any).
+    - UnderflowPolicy::Interpolate - Ramp from the second to last value received to the last, over as many ticks as it took the
+    last value to arrive. This delays values by one arrival, and requires an arithmetic ValueType or an interpolation function
+    (otherwise the last value is repeated).
+
+The behaviour of the sender when the ring is full (overflow) is configured via OverflowPolicy:
+    - OverflowPolicy::DropNewest - Discard the new value.
+    - OverflowPolicy::DropOldest - Discard the oldest value in the ring to make room for the new value.
+
+GetUnderflowCount() and GetOverflowCount() report how often each has occurred.
+*/
+
+template <typename ValueType>
+class CircuitBridge final
+{
+public:
+    enum class UnderflowPolicy
+    {
+        Drop,
+        Repeat,
+        Interpolate
+    };
+
+    enum class OverflowPolicy
+    {
+        DropNewest,
+        DropOldest
+    };
+
+    using Interpolator = std::function<ValueType( const ValueType& from, const ValueType& to, double position )>;
+
+    CircuitBridge( const CircuitBridge& ) = delete;
+    CircuitBridge& operator=( const CircuitBridge& ) = delete;
+
+    explicit CircuitBridge( size_t capacity,
+                            UnderflowPolicy underflowPolicy = UnderflowPolicy::Repeat,
+                            OverflowPolicy overflowPolicy = OverflowPolicy::DropOldest,
+                            const Interpolator& interpolator = nullptr );
+
+    Component::SPtr GetSender() const;
+    Component::SPtr GetReceiver() const;
+
+    size_t GetUnderflowCount() const;
+    size_t GetOverflowCount() const;
+
+private:
+    struct Ring final
+    {
+        explicit Ring( size_t capacity )
+            : values( capacity )
+        {
+        }
+
+        RingBuffer<ValueType> values;
+
+        std::atomic<size_t> underflowCount = { 0 };
+        std::atomic<size_t> overflowCount = { 0 };
+    };
+
+    class Sender final : public Component
+    {
+    public:
+        Sender( const std::shared_ptr<Ring>& ring, OverflowPolicy overflowPolicy );
+
+    protected:
+        void Process_( SignalBus& inputs, SignalBus& ) override;
+
+    private:
+        const std::shared_ptr<Ring> _ring;
+        const OverflowPolicy _overflowPolicy;
+        ValueType _dropped{};
+    };
+
+    class Receiver final : public Component
+    {
+    public:
+        Receiver( const std::shared_ptr<Ring>& ring, UnderflowPolicy underflowPolicy, const Interpolator& interpolator );
+
+    protected:
+        void Process_( SignalBus&, SignalBus& outputs ) override;
+
+    private:
+        static ValueType _Lerp( const ValueType& from, const ValueType& to, double position );
+
+        const std::shared_ptr<Ring> _ring;
+        const UnderflowPolicy _underflowPolicy;
+        const Interpolator _interpolator;
+
+        ValueType _newValue{};
+        ValueType _value{};  // last value received
+        bool _hasValue = false;
+
+        ValueType _from{};      // value received before last
+        int _period = 1;        // ticks it took the last value to arrive
+        int _sinceArrival = 0;  // ticks since the last value arrived
+    };
+
+    std::shared_ptr<Ring> _ring;
+
+    Component::SPtr _sender;
+    Component::SPtr _receiver;
+};
+
+template <typename ValueType>
+inline CircuitBridge<ValueType>::CircuitBridge( size_t capacity,
+                                                UnderflowPolicy underflowPolicy,
+                                                OverflowPolicy overflowPolicy,
+                                                const Interpolator& interpolator )
+    : _ring( std::make_shared<Ring>( capacity ) )
+    , _sender( std::make_shared<Sender>( _ring, overflowPolicy ) )
+    , _receiver( std::make_shared<Receiver>( _ring, underflowPolicy, interpolator ) )
+{
+}
+
+template <typename ValueType>
+inline Component::SPtr CircuitBridge<ValueType>::GetSender() const
+{
+    return _sender;
+}
+
+template <typename ValueType>
+inline Component::SPtr CircuitBridge<ValueType>::GetReceiver() const
+{
+    return _receiver;
+}
+
+template <typename ValueType>
+inline size_t CircuitBridge<ValueType>::GetUnderflowCount() const
+{
+    return _ring->underflowCount.load( std::memory_order_relaxed );
+}
+
+template <typename ValueType>
+inline size_t CircuitBridge<ValueType>::GetOverflowCount() const
+{
+    return _ring->overflowCount.load( std::memory_order_relaxed );
+}
+
+template <typename ValueType>
+inline CircuitBridge<ValueType>::Sender::Sender( const std::shared_ptr<Ring>& ring, OverflowPolicy overflowPolicy )
+    : _ring( ring )
+    , _overflowPolicy( overflowPolicy )
+{
+    SetInputCount_( 1 );
+}
+
+template <typename ValueType>
+inline void CircuitBridge<ValueType>::Sender::Process_( SignalBus& inputs, SignalBus& )
+{
+    auto value = inputs.GetValue<ValueType>( 0 );
+
+    if ( !value || _ring->values.TryPush( std::move( *value ) ) )
+    {
+        return;
+    }
+
+    _ring->overflowCount.fetch_add( 1, std::memory_order_relaxed );
+
+    if ( _overflowPolicy == OverflowPolicy::DropOldest )
+    {
+        // make room for the new value (unless the receiver just has)
+        _ring->values.TryPop( _dropped );
+        _ring->values.TryPush( std::move( *value ) );
+    }
+}
+
+template <typename ValueType>
+inline CircuitBridge<ValueType>::Receiver::Receiver( const std::shared_ptr<Ring>& ring,
+                                                     UnderflowPolicy underflowPolicy,
+                                                     const Interpolator& interpolator )
+    : _ring( ring )
+    , _underflowPolicy( underflowPolicy )
+    , _interpolator( interpolator ? interpolator : Interpolator( &_Lerp ) )
+{
+    SetOutputCount_( 1 );
+}
+
+template <typename ValueType>
+inline void CircuitBridge<ValueType>::Receiver::Process_( SignalBus&, SignalBus& outputs )
+{
+    if ( _ring->values.TryPop( _newValue ) )
+    {
+        if ( _underflowPolicy == UnderflowPolicy::Drop )
+        {
+            outputs.MoveValue( 0, std::move( _newValue ) );
+            return;
+        }
+
+        // ramp from the last value received (or from the new value, if it's the first)
+        _from = _hasValue ? std::move( _value ) : _newValue;
+        _period = _hasValue && _sinceArrival != 0 ? _sinceArrival : 1;
+        _sinceArrival = 0;
+
+        _value = std::move( _newValue );
+        _hasValue = true;
+    }
+    else
+    {
+        _ring->underflowCount.fetch_add( 1, std::memory_order_relaxed );
+
+        if ( _underflowPolicy == UnderflowPolicy::Drop || !_hasValue )
+        {
+            return;
+        }
+    }
+
+    if ( _underflowPolicy == UnderflowPolicy::Repeat )
+    {
+        outputs.SetValue( 0, _value );
+    }
+    else
+    {
+        const double position = _sinceArrival < _period ? (double)_sinceArrival / _period : 1.0;
+        outputs.MoveValue( 0, _interpolator( _from, _value, position ) );
+        ++_sinceArrival;
+    }
+}
+
+template <typename ValueType>
+inline ValueType CircuitBridge<ValueType>::Receiver::_Lerp( const ValueType& from, const ValueType& to, double position )
+{
+    if constexpr ( std::is_arithmetic_v<ValueType> )
+    {
+        return static_cast<ValueType>( from * ( 1.0 - position ) + to * position );
+    }
+    else
+    {
+        // no arithmetic to interpolate with, so just repeat the last value
+        return to;
+    }
+}
+
+}  // namespace DSPatch
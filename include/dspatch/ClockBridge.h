@@ -0,0 +1,367 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#include "Component.h"
+#include "RingBuffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace DSPatch
+{
+
+/// Bridge between an external clock (E.g. a driver callback) and an auto-ticking circuit
+
+/**
+Audio and data acquisition drivers typically hand each block of data to a callback on a thread with a hard deadline. Calling
+Circuit::Tick() from there isn't safe, as a tick may block on the circuit's thread synchronisation. A ClockBridge instead lets the
+callback exchange blocks with a circuit ticking on its own threads (see Circuit::StartAutoTick()), via a pair of lock-free
+RingBuffers. (The rings are lock-free, not wait-free: a push or pop only ever retries while contending with another push or pop on
+the same end of the ring, which never happens here, as each end is only used by one thread at a time.)
+
+A ClockBridge provides 2 built-in components: a source (GetSource()), that emits each input block handed to the bridge via
+Exchange(), and a sink (GetSink()), that collects each output block the circuit produces in return. Connect these to the
+circuit's processing components, then call Exchange() once per period from the driver callback. Exchange() never blocks or
+allocates (besides what moving InputType and OutputType involves), and only ever try-locks to wake a waiting source.
+
+The circuit runs "latency" periods ahead of the callback. The bridge starts out holding "latency" default-constructed output
+blocks, so each output block the callback receives was produced from the input block it handed over "latency" periods earlier.
+This gives the circuit "latency" periods to process each block, and so the circuit's buffer count (see Circuit::SetBufferCount())
+can be raised up to "latency" to process consecutive blocks in parallel.
+
+When the circuit misses a deadline, Exchange() returns false (leaving its output argument untouched) and counts an underrun (see
+GetUnderrunCount()). The late block is discarded once it arrives, keeping the circuit exactly "latency" periods ahead. Likewise,
+when the circuit has fallen so far behind that the bridge can't queue another input block, that block is discarded and an
+overrun is counted (see GetOverrunCount()). The circuit then runs a period less ahead from there on. Output blocks the sink can't
+queue because the callback isn't collecting them are discarded and counted separately (see GetOutputDropCount()).
+
+The source sleeps while waiting for each input block within the circuit's tick. If none arrives within 100ms (or the bridge is
+closed), the source gives up and emits nothing that tick, and the sink skips its output block to keep the pairing in step. So
+stopping the circuit's auto-tick never deadlocks, though calling Close() first, once the callback is done with the bridge, lets
+it stop without waiting out that timeout.
+*/
+
+template <typename InputType, typename OutputType>
+class ClockBridge final
+{
+public:
+    ClockBridge( const ClockBridge& ) = delete;
+    ClockBridge& operator=( const ClockBridge& ) = delete;
+
+    explicit ClockBridge( size_t latency = 1 );
+
+    Component::SPtr GetSource() const;
+    Component::SPtr GetSink() const;
+
+    bool Exchange( InputType&& input, OutputType& output );
+    bool Exchange( const InputType& input, OutputType& output );
+
+    void Close();
+    bool IsClosed() const;
+
+    size_t GetLatency() const;
+    size_t GetUnderrunCount() const;
+    size_t GetOverrunCount() const;
+    size_t GetOutputDropCount() const;
+
+private:
+    struct Rings final
+    {
+        // leave room for the circuit to fall behind / catch up by another "latency" periods
+        explicit Rings( size_t latency )
+            : inputs( latency * 2 )
+            , outputs( latency * 2 )
+        {
+        }
+
+        RingBuffer<InputType> inputs;
+        RingBuffer<OutputType> outputs;
+
+        std::atomic<bool> closed = { false };
+        std::atomic<size_t> overrunCount = { 0 };
+        std::atomic<size_t> outputDropCount = { 0 };
+        std::atomic<size_t> skipCount = { 0 };  // ticks the source gave up on, whose output blocks the sink should skip
+
+        // the source sleeps on waitCondt while the inputs ring is empty (see Source::Process_())
+        std::mutex waitMutex;
+        std::condition_variable waitCondt;
+        std::atomic<bool> waiting = { false };
+    };
+
+    class Source final : public Component
+    {
+    public:
+        explicit Source( const std::shared_ptr<Rings>& rings );
+
+    protected:
+        void Process_( SignalBus&, SignalBus& outputs ) override;
+
+    private:
+        static constexpr std::chrono::milliseconds _pollInterval{ 1 };
+        static constexpr std::chrono::milliseconds _stallTimeout{ 100 };
+
+        bool _WaitForInput();
+
+        const std::shared_ptr<Rings> _rings;
+        InputType _input{};
+    };
+
+    class Sink final : public Component
+    {
+    public:
+        explicit Sink( const std::shared_ptr<Rings>& rings );
+
+    protected:
+        void Process_( SignalBus& inputs, SignalBus& ) override;
+
+    private:
+        const std::shared_ptr<Rings> _rings;
+    };
+
+    template <typename T>
+    bool _Exchange( T&& input, OutputType& output );
+
+    const size_t _latency;
+
+    std::shared_ptr<Rings> _rings;
+
+    Component::SPtr _source;
+    Component::SPtr _sink;
+
+    std::atomic<size_t> _underrunCount = { 0 };
+
+    // only touched from the callback thread
+    size_t _lateCount = 0;
+    OutputType _lateOutput{};
+};
+
+template <typename InputType, typename OutputType>
+inline ClockBridge<InputType, OutputType>::ClockBridge( size_t latency )
+    : _latency( latency == 0 ? 1 : latency )
+    , _rings( std::make_shared<Rings>( _latency ) )
+    , _source( std::make_shared<Source>( _rings ) )
+    , _sink( std::make_shared<Sink>( _rings ) )
+{
+    // start "latency" periods ahead
+    for ( size_t i = 0; i < _latency; ++i )
+    {
+        _rings->outputs.TryPush( OutputType{} );
+    }
+}
+
+template <typename InputType, typename OutputType>
+inline Component::SPtr ClockBridge<InputType, OutputType>::GetSource() const
+{
+    return _source;
+}
+
+template <typename InputType, typename OutputType>
+inline Component::SPtr ClockBridge<InputType, OutputType>::GetSink() const
+{
+    return _sink;
+}
+
+template <typename InputType, typename OutputType>
+inline bool ClockBridge<InputType, OutputType>::Exchange( InputType&& input, OutputType& output )
+{
+    return _Exchange( std::move( input ), output );
+}
+
+template <typename InputType, typename OutputType>
+inline bool ClockBridge<InputType, OutputType>::Exchange( const InputType& input, OutputType& output )
+{
+    return _Exchange( input, output );
+}
+
+template <typename InputType, typename OutputType>
+inline void ClockBridge<InputType, OutputType>::Close()
+{
+    _rings->closed.store( true, std::memory_order_release );
+}
+
+template <typename InputType, typename OutputType>
+inline bool ClockBridge<InputType, OutputType>::IsClosed() const
+{
+    return _rings->closed.load( std::memory_order_acquire );
+}
+
+template <typename InputType, typename OutputType>
+inline size_t ClockBridge<InputType, OutputType>::GetLatency() const
+{
+    return _latency;
+}
+
+template <typename InputType, typename OutputType>
+inline size_t ClockBridge<InputType, OutputType>::GetUnderrunCount() const
+{
+    return _underrunCount.load( std::memory_order_relaxed );
+}
+
+template <typename InputType, typename OutputType>
+inline size_t ClockBridge<InputType, OutputType>::GetOverrunCount() const
+{
+    return _rings->overrunCount.load( std::memory_order_relaxed );
+}
+
+template <typename InputType, typename OutputType>
+inline size_t ClockBridge<InputType, OutputType>::GetOutputDropCount() const
+{
+    return _rings->outputDropCount.load( std::memory_order_relaxed );
+}
+
+template <typename InputType, typename OutputType>
+template <typename T>
+inline bool ClockBridge<InputType, OutputType>::_Exchange( T&& input, OutputType& output )
+{
+    if ( !_rings->inputs.TryPush( std::forward<T>( input ) ) )
+    {
+        _rings->overrunCount.fetch_add( 1, std::memory_order_relaxed );
+    }
+    else
+    {
+        // wake the source if it's waiting for this block (pairs with the fence in Source::_WaitForInput())
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        if ( _rings->waiting.load( std::memory_order_relaxed ) && _rings->waitMutex.try_lock() )
+        {
+            _rings->waitMutex.unlock();
+            _rings->waitCondt.notify_one();
+        }
+    }
+
+    // discard any blocks that arrived too late to be used
+    while ( _lateCount != 0 && _rings->outputs.TryPop( _lateOutput ) )
+    {
+        --_lateCount;
+    }
+
+    if ( _lateCount == 0 && _rings->outputs.TryPop( output ) )
+    {
+        return true;
+    }
+
+    // the block for this period is late
+    ++_lateCount;
+    _underrunCount.fetch_add( 1, std::memory_order_relaxed );
+    return false;
+}
+
+template <typename InputType, typename OutputType>
+inline ClockBridge<InputType, OutputType>::Source::Source( const std::shared_ptr<Rings>& rings )
+    : _rings( rings )
+{
+    SetOutputCount_( 1 );
+}
+
+template <typename InputType, typename OutputType>
+inline void ClockBridge<InputType, OutputType>::Source::Process_( SignalBus&, SignalBus& outputs )
+{
+    // wait for the callback to hand over the next input block
+    if ( !_rings->inputs.TryPop( _input ) && !_WaitForInput() )
+    {
+        // the callback has stopped (or closed the bridge), so have the sink skip this tick's output block too
+        _rings->skipCount.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+
+    outputs.MoveValue( 0, std::move( _input ) );
+}
+
+template <typename InputType, typename OutputType>
+inline bool ClockBridge<InputType, OutputType>::Source::_WaitForInput()
+{
+    // You might be thinking: Why poll at all, when Exchange() wakes us?
+
+    // Exchange() must never block, so it only try-locks waitMutex to wake us. Should that fail just
+    // as we're about to wait, the wake is missed, and the next poll picks up the block instead.
+
+    const auto deadline = std::chrono::steady_clock::now() + _stallTimeout;
+
+    std::unique_lock<std::mutex> lock( _rings->waitMutex );
+
+    _rings->waiting.store( true, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    bool popped = false;
+    while ( !( popped = _rings->inputs.TryPop( _input ) ) && !_rings->closed.load( std::memory_order_acquire ) )
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if ( now >= deadline )
+        {
+            break;
+        }
+        _rings->waitCondt.wait_until( lock, std::min( deadline, now + _pollInterval ) );
+    }
+
+    _rings->waiting.store( false, std::memory_order_relaxed );
+
+    return popped;
+}
+
+template <typename InputType, typename OutputType>
+inline ClockBridge<InputType, OutputType>::Sink::Sink( const std::shared_ptr<Rings>& rings )
+    : _rings( rings )
+{
+    SetInputCount_( 1 );
+}
+
+template <typename InputType, typename OutputType>
+inline void ClockBridge<InputType, OutputType>::Sink::Process_( SignalBus& inputs, SignalBus& )
+{
+    // You might be thinking: Why hand over a block even when we received no output this tick?
+
+    // The callback pairs each input block with the output block "latency" places behind it in the
+    // ring, so every tick must produce exactly one output block (even an empty one) for the pairing to
+    // stay in step.
+
+    auto output = inputs.GetValue<OutputType>( 0 );
+
+    if ( !output )
+    {
+        // the source gave up on a tick, so it produced no input block to pair an output block with
+        auto skipCount = _rings->skipCount.load( std::memory_order_relaxed );
+        while ( skipCount != 0 &&
+                !_rings->skipCount.compare_exchange_weak( skipCount, skipCount - 1, std::memory_order_relaxed ) )
+        {
+        }
+        if ( skipCount != 0 )
+        {
+            return;
+        }
+    }
+
+    if ( !_rings->outputs.TryPush( output ? std::move( *output ) : OutputType{} ) )
+    {
+        _rings->outputDropCount.fetch_add( 1, std::memory_order_relaxed );
+    }
+}
+
+}  // namespace DSPatch
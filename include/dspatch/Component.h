@@ -28,12 +28,20 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include "MemoryBudget.h"
+#include "PerfCounters.h"
+#include "Probes.h"
 #include "SignalBus.h"
 
 #include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace DSPatch
@@ -59,6 +67,69 @@ acquired input bus is then passed to the Process_() method.
 <b>PERFORMANCE TIP:</b> If a component is capable of processing its buffers out-of-order within a stream processing circuit,
 consider initialising its base with ProcessOrder::OutOfOrder to improve performance. Note however that Process_() must be
 thread-safe to operate in this mode.
+
+An in-order component's Process_() calls for consecutive buffers never overlap. If Process_() spends much of its time waiting (E.g.
+on I/O), it can call ReleaseNextBuffer_() (once) as soon as it's done with the component's own state, to let the next buffer's
+Process_() call begin while it waits.
+
+Each input can be assigned an InputPolicy via SetInputPolicy_() to move input availability checks out of Process_():
+    - InputPolicy::Optional - (Default) Process_() is called whether the input has a value or not.
+    - InputPolicy::Required - Process_() is skipped entirely on ticks where this input receives no value.
+    - InputPolicy::HoldLast - When this input receives no value, the last value it received is presented again instead. (Note:
+    Process_() should not move a held input's value out of the input bus, otherwise there'll be nothing left to hold. Out-of-order
+    components in multi-buffered circuits hold values per buffer).
+
+<b>PERFORMANCE TIP:</b> By default, a component's inputs are all fetched from their wires before Process_() is called. A component
+that only reads some of its inputs on each tick (E.g. a selector) can call SetLazyInputs_( true ) from its constructor to have
+each input fetched only when Process_() asks for it, via SignalBus::Fetch(). Inputs left unfetched are skipped without their
+signals being copied or moved. Note that inputs with an InputPolicy other than InputPolicy::Optional are fetched before Process_().
+
+Source components that are fed from outside the circuit (E.g. Injector) can override IsIdle_() to report when they have no data
+available, and call Wake_() when new data arrives. This allows a circuit auto-ticking in Circuit::AutoTickMode::IdleAware to park
+its auto-tick thread while all of its sources are idle.
+
+A component can be set to process only every Nth circuit tick via Circuit::SetRateDivisor() (see GetRateDivisor()). Wires between
+components of different rates carry the sending component's latest output rather than moving it along, so Process_() receives a
+held (or decimated) input on every tick it processes.
+
+For finite streams (E.g. offline batch processing), a component can call SetEndOfStream_() from Process_() once the outputs it
+sets in that call are its last. End-of-stream (EOS) then propagates through wires: a component reaches EOS in the same tick as
+the last of its input components does, which allows Circuit::RunToCompletion() to stop ticking exactly once every sink has seen
+EOS. EOS is tracked per buffer, and can be queried via IsEndOfStream() (and cleared via ResetEndOfStream()).
+
+SetInputCount_() and SetOutputCount_() resize a component's IO in place, so they're only safe to call while the component isn't
+being ticked (E.g. from its constructor, or while its circuit is paused). To change IO counts at runtime (E.g. a mixer gaining
+channels), use RequestInputCount_() and RequestOutputCount_() instead. These only record the request, leaving the circuit to apply
+it between ticks (see ApplyIORequests()). Wires to inputs and from outputs that no longer exist are disconnected.
+
+<b>PERFORMANCE TIP:</b> Call ReserveInputs_() and ReserveOutputs_() up front with the most IO a component expects to need. IO
+counts can then grow within that capacity without reallocating any of the component's per-buffer signal or reference storage.
+
+<b>PERFORMANCE TIP:</b> To find the fan-out points in a circuit that are costing the most in signal copies, enable per-wire
+transfer statistics via SetTransferStatsEnabled(). GetTransferStats() then reports how many signals arrived at an input via move,
+via copy, or not at all, as well as the approximate number of bytes copied (see SignalBus::SetSizeHook()).
+
+<b>PERFORMANCE TIP:</b> To find out whether a component is compute-bound or stalled on memory, enable hardware performance counters
+via SetPerfCountersEnabled(). GetPerfCounts() then reports the cycles, instructions, cache misses and branch misses counted while
+the component was in Process_() (see PerfCounters). These stay at 0 where counters are unavailable, or not compiled in (see
+DSPATCH_PERF_COUNTERS).
+
+When a MemoryBudget is assigned via SetMemoryBudget() (see Circuit::SetMemoryBudget()), the payload sizes of the outputs set in
+each Process_() call are accounted against it, once for every wire an output feeds (as all but the last receive a copy). Each
+payload is released again once it's moved on to another component (which accounts it in turn if it passes it on), or cleared on
+the component's next tick of the same buffer. Under MemoryBudget::Policy::Drop, outputs whose payloads don't fit within the
+budget are dropped on the spot. Only value types with a registered size hook are measured (see SignalBus::SetSizeHook()), other
+payloads count as 0 bytes.
+
+When compiled with DSPATCH_SIGNAL_METADATA defined, outputs left without metadata by Process_() are given the earliest origin among
+the signals the component received this tick (including those Process_() moved on), or, if it received none, the current time
+and tick (see SignalBus::Metadata).
+
+<b>PERFORMANCE TIP:</b> Process_() is virtual, so each call is an indirect call through the component's vtable. A circuit instead
+ticks each component via a tick function instantiated for its class (see TickAs() and Circuit::AddComponent()). Where that class is
+declared final, and its Process_() is reachable from Component (E.g. the class declares "friend class DSPatch::Component;"), that
+tick function calls Process_() directly, where the compiler can inline it. Large circuits also group components of the same class
+together within each level of their tick order, so consecutive calls tend to land on the same code.
 */
 
 class Component
@@ -75,6 +146,21 @@ public:
         OutOfOrder
     };
 
+    enum class InputPolicy
+    {
+        Optional,
+        Required,
+        HoldLast
+    };
+
+    struct TransferStats final
+    {
+        uint64_t moves = 0;
+        uint64_t copies = 0;
+        uint64_t empties = 0;
+        uint64_t copiedBytes = 0;
+    };
+
     Component( ProcessOrder processOrder = ProcessOrder::InOrder );
     virtual ~Component();
 
@@ -84,17 +170,59 @@ public:
     void DisconnectInput( const Component::SPtr& fromComponent );
     void DisconnectAllInputs();
 
+    ProcessOrder GetProcessOrder() const;
+
     int GetInputCount() const;
     int GetOutputCount() const;
 
     std::string GetInputName( int inputNo ) const;
     std::string GetOutputName( int outputNo ) const;
 
-    void SetBufferCount( int bufferCount, int startBuffer );
+    InputPolicy GetInputPolicy( int inputNo ) const;
+
+    template <typename Callback>
+    void ForEachInputWire( Callback&& callback ) const;
+
+    bool IsIdle() const;
+    void SetWakeCallback( const std::function<void()>& wakeCallback );
+
+    bool IsEndOfStream( int bufferNo ) const;
+    void ResetEndOfStream();
+
+    void SetIORequestCallback( const std::function<void()>& ioRequestCallback );
+    void ApplyIORequests();
+
+    void SetBufferCount( int bufferCount, int startBuffer, uint64_t startTick = 0 );
     int GetBufferCount() const;
 
+    void SetRateDivisor( int rateDivisor );
+    int GetRateDivisor() const;
+    void UpdateHeldInputs();
+
+    void SetTransferStatsEnabled( bool enabled );
+    bool GetTransferStatsEnabled() const;
+
+    TransferStats GetTransferStats( int inputNo ) const;
+    void ResetTransferStats();
+
+    void SetPerfCountersEnabled( bool enabled );
+    bool GetPerfCountersEnabled() const;
+
+    PerfCounters::Counts GetPerfCounts() const;
+    void ResetPerfCounts();
+
+    void SetMemoryBudget( const std::shared_ptr<MemoryBudget>& memoryBudget );
+
     void Tick( int bufferNo );
     void TickParallel( int bufferNo );
+    void TickDetached( int bufferNo );
+
+    template <typename ComponentType>
+    static void TickAs( Component* component, int bufferNo );
+    template <typename ComponentType>
+    static void TickParallelAs( Component* component, int bufferNo );
+
+    void SetThreadLocalOutput( int outputNo, bool threadLocal );
 
     void Scan( std::vector<Component*>& components );
     void ScanParallel( std::vector<std::vector<DSPatch::Component*>>& componentsMap, int& scanPosition );
@@ -103,9 +231,30 @@ public:
 protected:
     inline virtual void Process_( SignalBus&, SignalBus& ) = 0;
 
+    inline virtual bool IsIdle_() const
+    {
+        return false;
+    }
+
+    void Wake_() const;
+
+    void SetEndOfStream_();
+
     void SetInputCount_( int inputCount, const std::vector<std::string>& inputNames = {} );
     void SetOutputCount_( int outputCount, const std::vector<std::string>& outputNames = {} );
 
+    void RequestInputCount_( int inputCount, const std::vector<std::string>& inputNames = {} );
+    void RequestOutputCount_( int outputCount, const std::vector<std::string>& outputNames = {} );
+
+    void ReserveInputs_( int inputCount );
+    void ReserveOutputs_( int outputCount );
+
+    void SetInputPolicy_( int inputNo, InputPolicy policy );
+
+    void SetLazyInputs_( bool lazyInputs );
+
+    void ReleaseNextBuffer_();
+
 private:
     class AtomicFlag final
     {
@@ -145,6 +294,7 @@ private:
     {
         int count = 0;
         int total = 0;
+        bool threadLocal = false;  // every reference is ticked on this component's thread, after it
         AtomicFlag readyFlag;
     };
 
@@ -153,16 +303,83 @@ private:
         DSPatch::Component* fromComponent;
         int fromOutput;
         int toInput;
+        bool held;  // the wire crosses rates, so carries fromComponent's held output (see SetRateDivisor())
+    };
+
+    enum class Transfer
+    {
+        Empty,
+        Move,
+        Copy
+    };
+
+    enum class TickMode
+    {
+        Series,
+        Parallel,
+        Detached
+    };
+
+    struct LazyFetch final
+    {
+        DSPatch::Component* component = nullptr;
+        int bufferNo = 0;
+        TickMode tickMode = TickMode::Series;
+        std::vector<const Wire*> pendingWires;  // wire per input, until its signal is fetched
     };
 
     void _WaitForRelease( int bufferNo );
     void _ReleaseNextBuffer( int bufferNo );
 
-    void _GetOutput( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus );
-    void _GetOutputParallel( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus );
+    template <typename ComponentType>
+    void _Tick( int bufferNo );
+    template <typename ComponentType>
+    void _TickParallel( int bufferNo );
+
+    template <typename ComponentType>
+    static auto _CanProcessDirectly( int )
+        -> decltype( std::declval<ComponentType&>().Process_( std::declval<SignalBus&>(), std::declval<SignalBus&>() ),
+                     std::true_type() );
+    template <typename ComponentType>
+    static std::false_type _CanProcessDirectly( ... );
+
+    template <typename ComponentType>
+    void _CallProcess( DSPatch::SignalBus& inputBus, DSPatch::SignalBus& outputBus );
+    template <typename ComponentType = Component>
+    void _Process( int bufferNo, DSPatch::SignalBus& inputBus, DSPatch::SignalBus& outputBus );
+    template <typename ComponentType>
+    void _ProcessWithPolicies( int bufferNo, DSPatch::SignalBus& inputBus, DSPatch::SignalBus& outputBus );
+    void _HandOverHeldInputs( int bufferNo );
+
+    bool _InputsEnded( int bufferNo ) const;
+
+#ifdef DSPATCH_SIGNAL_METADATA
+    void _StampOutputs( int bufferNo, const DSPatch::SignalBus& inputBus, DSPatch::SignalBus& outputBus ) const;
+#endif
+
+    void _AccountOutputs( int bufferNo, DSPatch::SignalBus& outputBus );
+    void _ReleaseOutput( int bufferNo, int outputNo );
+
+    Transfer _GetOutput( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus );
+    Transfer _GetOutputParallel( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus );
+    void _CopyOutput( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus );
+
+    void _RecordTransfer( int bufferNo, int toInput, Transfer transfer, const DSPatch::SignalBus& toBus );
 
-    void _IncRefs( int output );
-    void _DecRefs( int output );
+    void _DeferInputs( int bufferNo, TickMode tickMode );
+    void _SkipInputs( int bufferNo );
+    static void _FetchInput( void* lazyFetch, int inputNo );
+
+    void _SkipOutput( int bufferNo, int fromOutput );
+    void _SkipOutputParallel( int bufferNo, int fromOutput );
+
+    void _IncRefs( int output, bool held );
+    void _DecRefs( int output, bool held );
+
+    bool _OnRate( int bufferNo );
+    void _SkipTick( int bufferNo );
+    void _HoldOutputs( DSPatch::SignalBus& outputBus );
+    Transfer _GetHeldOutput( int fromOutput, int toInput, DSPatch::SignalBus& toBus );
 
     const DSPatch::Component::ProcessOrder _processOrder;
 
@@ -176,10 +393,55 @@ private:
     std::vector<Wire> _inputWires;
 
     std::vector<AtomicFlag> _releaseFlags;
+    std::atomic<int> _releasingBuffer = -1;  // in-order buffer processing, until it releases the next buffer
 
     std::vector<std::string> _inputNames;
     std::vector<std::string> _outputNames;
 
+    bool _hasInputPolicies = false;
+    std::vector<InputPolicy> _inputPolicies;
+    std::vector<DSPatch::SignalBus> _heldInputs;  // only [0] is used by in-order components
+    std::vector<char> _heldInputsHandedOver;      // per buffer, set where ReleaseNextBuffer_() has handed its held inputs over
+
+    bool _lazyInputs = false;
+    std::vector<LazyFetch> _lazyFetches;  // LazyFetch per buffer
+
+    mutable std::mutex _wakeMutex;  // (Wake_() is called from outside the circuit, E.g. by a producer thread)
+    std::function<void()> _wakeCallback;
+
+    std::mutex _ioRequestMutex;
+    int _requestedInputCount = -1;
+    int _requestedOutputCount = -1;
+    std::vector<std::string> _requestedInputNames;
+    std::vector<std::string> _requestedOutputNames;
+    std::function<void()> _ioRequestCallback;
+
+    int _reservedInputCount = 0;
+    int _reservedOutputCount = 0;
+
+    std::atomic<bool> _endOfStreamSet = false;
+    std::vector<char> _endOfStream;  // EOS flag per buffer
+
+    bool _transferStatsEnabled = false;
+    std::vector<std::vector<TransferStats>> _transferStats;  // TransferStats per input, per buffer
+
+    bool _perfCountersEnabled = false;
+    std::vector<PerfCounters::Counts> _perfCounts;  // PerfCounters::Counts per buffer
+
+    std::shared_ptr<MemoryBudget> _memoryBudget;
+    std::vector<std::vector<size_t>> _outputBytes;  // payload bytes accounted per output, per buffer
+
+    int _rateDivisor = 1;
+    std::vector<uint64_t> _tickNos;  // circuit tick number of the next tick, per buffer
+
+    bool _hasHeldRefs = false;
+    std::vector<int> _heldRefCounts;  // held reference count per output
+    DSPatch::SignalBus _heldOutputs[2];  // front (read by held wires) and back (written by _HoldOutputs()) held outputs
+    std::atomic<int> _heldFront = { 0 };
+    std::atomic<int> _heldReaders[2] = {};  // held wires reading from each of _heldOutputs
+    std::atomic_flag _heldWriting = ATOMIC_FLAG_INIT;  // (only out-of-order components can hold outputs concurrently)
+    std::atomic<bool> _heldEndOfStream = { false };  // EOS as seen by held wires, which don't sync with our ticks
+
     int _scanPosition = -1;
 };
 
@@ -201,6 +463,8 @@ inline bool Component::ConnectInput( const Component::SPtr& fromComponent, int f
     // first make sure there are no wires already connected to this input
     auto findFn = [&toInput]( const auto& wire ) { return wire.toInput == toInput; };
 
+    const bool held = fromComponent->_rateDivisor != _rateDivisor;
+
     if ( auto it = std::find_if( _inputWires.begin(), _inputWires.end(), findFn ); it != _inputWires.end() )
     {
         if ( it->fromComponent == fromComponent.get() && it->fromOutput == fromOutput )
@@ -210,20 +474,21 @@ inline bool Component::ConnectInput( const Component::SPtr& fromComponent, int f
         }
 
         // update source output's reference count
-        it->fromComponent->_DecRefs( it->fromOutput );
+        it->fromComponent->_DecRefs( it->fromOutput, it->held );
 
         // replace wire
         it->fromComponent = fromComponent.get();
         it->fromOutput = fromOutput;
+        it->held = held;
     }
     else
     {
         // add new wire
-        _inputWires.emplace_back( Wire{ fromComponent.get(), fromOutput, toInput } );
+        _inputWires.emplace_back( Wire{ fromComponent.get(), fromOutput, toInput, held } );
     }
 
     // update source output's reference count
-    fromComponent->_IncRefs( fromOutput );
+    fromComponent->_IncRefs( fromOutput, held );
 
     return true;
 }
@@ -236,7 +501,7 @@ inline void Component::DisconnectInput( int inputNo )
     if ( auto it = std::find_if( _inputWires.begin(), _inputWires.end(), findFn ); it != _inputWires.end() )
     {
         // update source output's reference count
-        it->fromComponent->_DecRefs( it->fromOutput );
+        it->fromComponent->_DecRefs( it->fromOutput, it->held );
 
         _inputWires.erase( it );
     }
@@ -251,7 +516,7 @@ inline void Component::DisconnectInput( const Component::SPtr& fromComponent )
           it = std::find_if( it, _inputWires.end(), findFn ) )
     {
         // update source output's reference count
-        fromComponent->_DecRefs( it->fromOutput );
+        fromComponent->_DecRefs( it->fromOutput, it->held );
 
         it = _inputWires.erase( it );
     }
@@ -263,12 +528,17 @@ inline void Component::DisconnectAllInputs()
     for ( const auto& wire : _inputWires )
     {
         // update source output's reference count
-        wire.fromComponent->_DecRefs( wire.fromOutput );
+        wire.fromComponent->_DecRefs( wire.fromOutput, wire.held );
     }
 
     _inputWires.clear();
 }
 
+inline Component::ProcessOrder Component::GetProcessOrder() const
+{
+    return _processOrder;
+}
+
 inline int Component::GetInputCount() const
 {
     return _inputBuses[0].GetSignalCount();
@@ -299,7 +569,93 @@ inline std::string Component::GetOutputName( int outputNo ) const
     return "";
 }
 
-inline void Component::SetBufferCount( int bufferCount, int startBuffer )
+template <typename Callback>
+inline void Component::ForEachInputWire( Callback&& callback ) const
+{
+    // callback( fromComponent, fromOutput, toInput )
+    for ( const auto& wire : _inputWires )
+    {
+        callback( wire.fromComponent, wire.fromOutput, wire.toInput );
+    }
+}
+
+inline bool Component::IsIdle() const
+{
+    return IsIdle_();
+}
+
+inline void Component::SetWakeCallback( const std::function<void()>& wakeCallback )
+{
+    // once this returns, no call to the previous callback is still in progress
+    std::lock_guard<std::mutex> lock( _wakeMutex );
+    _wakeCallback = wakeCallback;
+}
+
+inline bool Component::IsEndOfStream( int bufferNo ) const
+{
+    return _endOfStream[bufferNo];
+}
+
+// cppcheck-suppress unusedFunction
+inline void Component::ResetEndOfStream()
+{
+    _endOfStreamSet = false;
+    std::fill( _endOfStream.begin(), _endOfStream.end(), 0 );
+    _heldEndOfStream.store( false, std::memory_order_relaxed );
+}
+
+inline void Component::SetIORequestCallback( const std::function<void()>& ioRequestCallback )
+{
+    std::lock_guard<std::mutex> lock( _ioRequestMutex );
+    _ioRequestCallback = ioRequestCallback;
+}
+
+inline void Component::ApplyIORequests()
+{
+    int inputCount, outputCount;
+    std::vector<std::string> inputNames, outputNames;
+
+    {
+        std::lock_guard<std::mutex> lock( _ioRequestMutex );
+
+        inputCount = _requestedInputCount;
+        outputCount = _requestedOutputCount;
+        inputNames.swap( _requestedInputNames );
+        outputNames.swap( _requestedOutputNames );
+
+        _requestedInputCount = -1;
+        _requestedOutputCount = -1;
+    }
+
+    if ( inputCount != -1 )
+    {
+        // disconnect wires to inputs that are about to be removed
+        for ( int i = inputCount; i < GetInputCount(); ++i )
+        {
+            DisconnectInput( i );
+        }
+
+        SetInputCount_( inputCount, inputNames );
+    }
+
+    if ( outputCount != -1 )
+    {
+        // wires from removed outputs are left to the circuit to disconnect (see Circuit::Tick())
+        SetOutputCount_( outputCount, outputNames );
+    }
+}
+
+// cppcheck-suppress unusedFunction
+inline Component::InputPolicy Component::GetInputPolicy( int inputNo ) const
+{
+    if ( inputNo < (int)_inputPolicies.size() )
+    {
+        return _inputPolicies[inputNo];
+    }
+    return InputPolicy::Optional;
+}
+
+inline void Component::SetBufferCount( int bufferCount, int startBuffer, uint64_t startTick )
 {
     // _bufferCount is the current thread count / bufferCount is new thread count
 
@@ -321,6 +677,34 @@ inline void Component::SetBufferCount( int bufferCount, int startBuffer )
 
     _refs.resize( bufferCount );
 
+    _transferStats.resize( bufferCount );
+
+    _perfCounts.resize( bufferCount );
+
+    // release the payloads of buffers that are about to be removed
+    if ( _memoryBudget )
+    {
+        for ( int i = bufferCount; i < (int)_outputBytes.size(); ++i )
+        {
+            for ( auto bytes : _outputBytes[i] )
+            {
+                _memoryBudget->Release( bytes );
+            }
+        }
+    }
+    _outputBytes.resize( bufferCount );
+
+    _heldInputs.resize( bufferCount );
+    _heldInputsHandedOver.assign( bufferCount, 0 );
+
+    _lazyFetches.resize( bufferCount );
+
+    _tickNos.resize( bufferCount );
+
+    // a stream that ended in any buffer has ended in all of them
+    const char endOfStream = std::find( _endOfStream.begin(), _endOfStream.end(), 1 ) != _endOfStream.end();
+    _endOfStream.assign( bufferCount, endOfStream );
+
     const auto inputCount = GetInputCount();
     const auto outputCount = GetOutputCount();
     const auto refCount = _refs[0].size();
@@ -328,9 +712,23 @@ inline void Component::SetBufferCount( int bufferCount, int startBuffer )
     // init vector values
     for ( int i = 0; i < bufferCount; ++i )
     {
+        _inputBuses[i].ReserveSignals( _reservedInputCount );
+        _outputBuses[i].ReserveSignals( _reservedOutputCount );
         _inputBuses[i].SetSignalCount( inputCount );
         _outputBuses[i].SetSignalCount( outputCount );
 
+        _transferStats[i].reserve( _reservedInputCount );
+        _transferStats[i].resize( inputCount );
+
+        _heldInputs[i].ReserveSignals( _reservedInputCount );
+        _heldInputs[i].SetSignalCount( inputCount );
+
+        _lazyFetches[i].component = this;
+        _lazyFetches[i].bufferNo = i;
+
+        // the circuit's next tick (startTick) goes to startBuffer, the tick after to the buffer after, and so on
+        _tickNos[i] = startTick + ( i - startBuffer + bufferCount ) % bufferCount;
+
         if ( i == startBuffer )
         {
             _releaseFlags[i].Set();
@@ -340,11 +738,13 @@ inline void Component::SetBufferCount( int bufferCount, int startBuffer )
             _releaseFlags[i].Clear();
         }
 
+        _refs[i].reserve( _reservedOutputCount );
         _refs[i].resize( refCount );
         for ( size_t j = 0; j < refCount; ++j )
         {
             // sync output reference counts
             _refs[i][j].total = _refs[0][j].total;
+            _refs[i][j].threadLocal = _refs[0][j].threadLocal;
         }
     }
 
@@ -356,18 +756,155 @@ inline int Component::GetBufferCount() const
     return (int)_inputBuses.size();
 }
 
+inline void Component::SetTransferStatsEnabled( bool enabled )
+{
+    _transferStatsEnabled = enabled;
+}
+
+// cppcheck-suppress unusedFunction
+inline bool Component::GetTransferStatsEnabled() const
+{
+    return _transferStatsEnabled;
+}
+
+inline Component::TransferStats Component::GetTransferStats( int inputNo ) const
+{
+    // sum the stats of this input across all buffers
+
+    TransferStats result;
+
+    if ( inputNo < 0 || inputNo >= GetInputCount() )
+    {
+        return result;
+    }
+
+    for ( const auto& stats : _transferStats )
+    {
+        result.moves += stats[inputNo].moves;
+        result.copies += stats[inputNo].copies;
+        result.empties += stats[inputNo].empties;
+        result.copiedBytes += stats[inputNo].copiedBytes;
+    }
+
+    return result;
+}
+
+inline void Component::ResetTransferStats()
+{
+    for ( auto& stats : _transferStats )
+    {
+        std::fill( stats.begin(), stats.end(), TransferStats{} );
+    }
+}
+
+inline void Component::SetPerfCountersEnabled( bool enabled )
+{
+    _perfCountersEnabled = enabled;
+}
+
+// cppcheck-suppress unusedFunction
+inline bool Component::GetPerfCountersEnabled() const
+{
+    return _perfCountersEnabled;
+}
+
+inline PerfCounters::Counts Component::GetPerfCounts() const
+{
+    // sum the counts across all buffers
+
+    PerfCounters::Counts result;
+
+    for ( const auto& counts : _perfCounts )
+    {
+        result += counts;
+    }
+
+    return result;
+}
+
+inline void Component::ResetPerfCounts()
+{
+    std::fill( _perfCounts.begin(), _perfCounts.end(), PerfCounters::Counts{} );
+}
+
+inline void Component::SetMemoryBudget( const std::shared_ptr<MemoryBudget>& memoryBudget )
+{
+    // NOTE: Only safe to call while the component isn't being ticked (E.g. while its circuit is paused)
+
+    if ( _memoryBudget )
+    {
+        for ( auto& outputBytes : _outputBytes )
+        {
+            for ( auto& bytes : outputBytes )
+            {
+                _memoryBudget->Release( bytes );
+                bytes = 0;
+            }
+        }
+    }
+
+    _memoryBudget = memoryBudget;
+}
+
 inline void Component::Tick( int bufferNo )
 {
+    _Tick<Component>( bufferNo );
+}
+
+inline void Component::TickParallel( int bufferNo )
+{
+    _TickParallel<Component>( bufferNo );
+}
+
+template <typename ComponentType>
+inline void Component::TickAs( Component* component, int bufferNo )
+{
+    static_assert( std::is_base_of_v<Component, ComponentType>, "TickAs() requires a component class" );
+
+    component->_Tick<ComponentType>( bufferNo );
+}
+
+template <typename ComponentType>
+inline void Component::TickParallelAs( Component* component, int bufferNo )
+{
+    static_assert( std::is_base_of_v<Component, ComponentType>, "TickParallelAs() requires a component class" );
+
+    component->_TickParallel<ComponentType>( bufferNo );
+}
+
+template <typename ComponentType>
+inline void Component::_Tick( int bufferNo )
+{
+    if ( !_OnRate( bufferNo ) )
+    {
+        _SkipTick( bufferNo );
+        return;
+    }
+
     auto& inputBus = _inputBuses[bufferNo];
     auto& outputBus = _outputBuses[bufferNo];
 
     // clear inputs
     inputBus.ClearAllValues();
 
-    for ( const auto& wire : _inputWires )
+    if ( _lazyInputs )
     {
-        // get new inputs from incoming components
-        wire.fromComponent->_GetOutput( bufferNo, wire.fromOutput, wire.toInput, inputBus );
+        // leave inputs to be fetched as Process_() reads them
+        _DeferInputs( bufferNo, TickMode::Series );
+    }
+    else
+    {
+        for ( const auto& wire : _inputWires )
+        {
+            // get new inputs from incoming components
+            auto transfer = wire.held ? wire.fromComponent->_GetHeldOutput( wire.fromOutput, wire.toInput, inputBus )
+                                      : wire.fromComponent->_GetOutput( bufferNo, wire.fromOutput, wire.toInput, inputBus );
+
+            if ( _transferStatsEnabled )
+            {
+                _RecordTransfer( bufferNo, wire.toInput, transfer, inputBus );
+            }
+        }
     }
 
     // clear outputs
@@ -377,22 +914,40 @@ inline void Component::Tick( int bufferNo )
     {
         // wait for our turn to process
         _WaitForRelease( bufferNo );
+        _releasingBuffer.store( bufferNo, std::memory_order_relaxed );
 
         // call Process_() with newly aquired inputs
-        Process_( inputBus, outputBus );
+        _Process<ComponentType>( bufferNo, inputBus, outputBus );
 
-        // signal that we're done processing
-        _ReleaseNextBuffer( bufferNo );
+        // signal that we're done processing (unless Process_() already has via ReleaseNextBuffer_())
+        int releasingBuffer = bufferNo;
+        if ( _releasingBuffer.compare_exchange_strong( releasingBuffer, -1, std::memory_order_relaxed ) )
+        {
+            _ReleaseNextBuffer( bufferNo );
+        }
     }
     else
     {
         // call Process_() with newly aquired inputs
-        Process_( inputBus, outputBus );
+        _Process<ComponentType>( bufferNo, inputBus, outputBus );
+    }
+
+    if ( _lazyInputs )
+    {
+        // release the inputs Process_() didn't read
+        _SkipInputs( bufferNo );
     }
 }
 
-inline void Component::TickParallel( int bufferNo )
+template <typename ComponentType>
+inline void Component::_TickParallel( int bufferNo )
 {
+    if ( !_OnRate( bufferNo ) )
+    {
+        _SkipTick( bufferNo );
+        return;
+    }
+
     auto& inputBus = _inputBuses[bufferNo];
     auto& outputBus = _outputBuses[bufferNo];
 
@@ -400,65 +955,147 @@ inline void Component::TickParallel( int bufferNo )
     inputBus.ClearAllValues();
     outputBus.ClearAllValues();
 
-    for ( const auto& wire : _inputWires )
+    if ( _lazyInputs )
+    {
+        // leave inputs to be fetched as Process_() reads them
+        _DeferInputs( bufferNo, TickMode::Parallel );
+    }
+    else
     {
-        // get new inputs from incoming components
-        wire.fromComponent->_GetOutputParallel( bufferNo, wire.fromOutput, wire.toInput, inputBus );
+        for ( const auto& wire : _inputWires )
+        {
+            // get new inputs from incoming components
+            auto transfer = wire.held ? wire.fromComponent->_GetHeldOutput( wire.fromOutput, wire.toInput, inputBus )
+                                      : wire.fromComponent->_GetOutputParallel( bufferNo, wire.fromOutput, wire.toInput, inputBus );
+
+            if ( _transferStatsEnabled )
+            {
+                _RecordTransfer( bufferNo, wire.toInput, transfer, inputBus );
+            }
+        }
     }
 
     if ( _bufferCount != 1 && _processOrder == ProcessOrder::InOrder )
     {
         // wait for our turn to process
         _WaitForRelease( bufferNo );
+        _releasingBuffer.store( bufferNo, std::memory_order_relaxed );
 
         // call Process_() with newly aquired inputs
-        Process_( inputBus, outputBus );
+        _Process<ComponentType>( bufferNo, inputBus, outputBus );
 
-        // signal that we're done processing
-        _ReleaseNextBuffer( bufferNo );
+        // signal that we're done processing (unless Process_() already has via ReleaseNextBuffer_())
+        int releasingBuffer = bufferNo;
+        if ( _releasingBuffer.compare_exchange_strong( releasingBuffer, -1, std::memory_order_relaxed ) )
+        {
+            _ReleaseNextBuffer( bufferNo );
+        }
     }
     else
     {
         // call Process_() with newly aquired inputs
-        Process_( inputBus, outputBus );
+        _Process<ComponentType>( bufferNo, inputBus, outputBus );
+    }
+
+    if ( _lazyInputs )
+    {
+        // release the inputs Process_() didn't read
+        _SkipInputs( bufferNo );
     }
 
     // signal that our outputs are ready
     for ( auto& ref : _refs[bufferNo] )
     {
         // readyFlags are cleared in _GetOutputParallel() which ofc is only called on outputs with refs
-        if ( ref.total != 0 )
+        if ( ref.total != 0 && !ref.threadLocal )
         {
             ref.readyFlag.Set();
         }
     }
 }
 
-inline void Component::Scan( std::vector<Component*>& components )
+inline void Component::SetThreadLocalOutput( int outputNo, bool threadLocal )
 {
-    // continue only if this component has not already been scanned
-    if ( _scanPosition != -1 )
-    {
-        return;
-    }
+    // You might be thinking: Why not just skip the readyFlag for every same-thread wire?
 
-    // initialize _scanPosition
-    _scanPosition = 0;
+    // Every reference to an output takes its turn via the same readyFlag (see _GetOutputParallel()),
+    // including the reference count that decides who copies and who moves. So the readyFlag can only
+    // be skipped once no other thread takes part at all: when all of an output's references are on
+    // this component's thread, and ticked after it. See Circuit::Scheduling::Partitioned.
 
-    for ( const auto& wire : _inputWires )
+    for ( auto& ref : _refs )
     {
-        // scan incoming components
-        wire.fromComponent->Scan( components );
+        ref[outputNo].threadLocal = threadLocal;
     }
-
-    components.emplace_back( this );
 }
 
-inline void Component::ScanParallel( std::vector<std::vector<DSPatch::Component*>>& componentsMap, int& scanPosition )
+inline void Component::TickDetached( int bufferNo )
 {
-    // continue only if this component has not already been scanned
-    if ( _scanPosition != -1 )
-    {
+    // You might be thinking: Why not just call Tick() here?
+
+    // TickDetached() is used to tick a subset of a circuit (see Circuit::TickSubgraph()). Components
+    // outside that subset don't get ticked, so this component can't move signals out of its input
+    // components' outputs (others may still need them), nor take part in the buffer release order
+    // (components outside the subset won't advance theirs). Hence, signals are copied, and buffer
+    // release flags and reference counts are left untouched.
+
+    auto& inputBus = _inputBuses[bufferNo];
+    auto& outputBus = _outputBuses[bufferNo];
+
+    // clear inputs
+    inputBus.ClearAllValues();
+
+    if ( _lazyInputs )
+    {
+        // leave inputs to be copied as Process_() reads them
+        _DeferInputs( bufferNo, TickMode::Detached );
+    }
+    else
+    {
+        for ( const auto& wire : _inputWires )
+        {
+            // copy new inputs from incoming components
+            wire.fromComponent->_CopyOutput( bufferNo, wire.fromOutput, wire.toInput, inputBus );
+        }
+    }
+
+    // clear outputs
+    outputBus.ClearAllValues();
+
+    // call Process_() with newly aquired inputs
+    _Process( bufferNo, inputBus, outputBus );
+
+    if ( _lazyInputs )
+    {
+        _SkipInputs( bufferNo );
+    }
+}
+
+inline void Component::Scan( std::vector<Component*>& components )
+{
+    // continue only if this component has not already been scanned
+    if ( _scanPosition != -1 )
+    {
+        return;
+    }
+
+    // initialize _scanPosition
+    _scanPosition = 0;
+
+    for ( const auto& wire : _inputWires )
+    {
+        // scan incoming components
+        wire.fromComponent->Scan( components );
+    }
+
+    components.emplace_back( this );
+}
+
+inline void Component::ScanParallel( std::vector<std::vector<DSPatch::Component*>>& componentsMap, int& scanPosition )
+{
+    // continue only if this component has not already been scanned
+    if ( _scanPosition != -1 )
+    {
         scanPosition = _scanPosition;
         return;
     }
@@ -476,6 +1113,9 @@ inline void Component::ScanParallel( std::vector<std::vector<DSPatch::Component*
         _scanPosition = std::max( _scanPosition, ++scanPosition );
     }
 
+    // report our own scanPosition (not that of our last input) back to the component scanning us
+    scanPosition = _scanPosition;
+
     // insert component at _scanPosition
     if ( _scanPosition == (int)componentsMap.size() )
     {
@@ -500,6 +1140,21 @@ inline void Component::SetInputCount_( int inputCount, const std::vector<std::st
         inputBus.SetSignalCount( inputCount );
     }
 
+    for ( auto& stats : _transferStats )
+    {
+        stats.resize( inputCount );
+    }
+
+    for ( auto& heldInputs : _heldInputs )
+    {
+        heldInputs.SetSignalCount( inputCount );
+    }
+
+    _inputPolicies.resize( inputCount, InputPolicy::Optional );
+    _hasInputPolicies = std::any_of( _inputPolicies.begin(), _inputPolicies.end(), []( auto inputPolicy ) {
+        return inputPolicy != InputPolicy::Optional;
+    } );
+
     _inputWires.reserve( inputCount );
 }
 
@@ -519,9 +1174,165 @@ inline void Component::SetOutputCount_( int outputCount, const std::vector<std::
     }
 }
 
+inline void Component::RequestInputCount_( int inputCount, const std::vector<std::string>& inputNames )
+{
+    std::unique_lock<std::mutex> lock( _ioRequestMutex );
+
+    _requestedInputCount = inputCount;
+    _requestedInputNames = inputNames;
+
+    if ( _ioRequestCallback )
+    {
+        _ioRequestCallback();
+        return;
+    }
+
+    // no circuit to defer to, so apply the request straight away
+    lock.unlock();
+    ApplyIORequests();
+}
+
+inline void Component::RequestOutputCount_( int outputCount, const std::vector<std::string>& outputNames )
+{
+    std::unique_lock<std::mutex> lock( _ioRequestMutex );
+
+    _requestedOutputCount = outputCount;
+    _requestedOutputNames = outputNames;
+
+    if ( _ioRequestCallback )
+    {
+        _ioRequestCallback();
+        return;
+    }
+
+    // no circuit to defer to, so apply the request straight away
+    lock.unlock();
+    ApplyIORequests();
+}
+
+inline void Component::ReserveInputs_( int inputCount )
+{
+    _reservedInputCount = std::max( _reservedInputCount, inputCount );
+
+    for ( auto& inputBus : _inputBuses )
+    {
+        inputBus.ReserveSignals( _reservedInputCount );
+    }
+
+    for ( auto& stats : _transferStats )
+    {
+        stats.reserve( _reservedInputCount );
+    }
+
+    for ( auto& heldInputs : _heldInputs )
+    {
+        heldInputs.ReserveSignals( _reservedInputCount );
+    }
+
+    _inputPolicies.reserve( _reservedInputCount );
+    _inputWires.reserve( _reservedInputCount );
+}
+
+inline void Component::ReserveOutputs_( int outputCount )
+{
+    _reservedOutputCount = std::max( _reservedOutputCount, outputCount );
+
+    for ( auto& outputBus : _outputBuses )
+    {
+        outputBus.ReserveSignals( _reservedOutputCount );
+    }
+
+    for ( auto& ref : _refs )
+    {
+        ref.reserve( _reservedOutputCount );
+    }
+}
+
+inline void Component::Wake_() const
+{
+    std::lock_guard<std::mutex> lock( _wakeMutex );
+
+    if ( _wakeCallback )
+    {
+        _wakeCallback();
+    }
+}
+
+inline void Component::SetEndOfStream_()
+{
+    _endOfStreamSet.store( true, std::memory_order_relaxed );
+}
+
+inline void Component::ReleaseNextBuffer_()
+{
+    // NOTE: This must only be called once per Process_() call, as the next buffer may be processing by the time it returns
+
+    auto releasingBuffer = _releasingBuffer.exchange( -1, std::memory_order_relaxed );
+
+    if ( releasingBuffer != -1 )
+    {
+        if ( _hasInputPolicies )
+        {
+            _HandOverHeldInputs( releasingBuffer );
+        }
+
+        _ReleaseNextBuffer( releasingBuffer );
+    }
+}
+
+inline void Component::SetRateDivisor( int rateDivisor )
+{
+    // NOTE: Circuit::SetRateDivisor() should be used for components in a circuit, as wires need updating too
+
+    _rateDivisor = rateDivisor < 1 ? 1 : rateDivisor;
+}
+
+inline int Component::GetRateDivisor() const
+{
+    return _rateDivisor;
+}
+
+inline void Component::UpdateHeldInputs()
+{
+    for ( auto& wire : _inputWires )
+    {
+        const bool held = wire.fromComponent->_rateDivisor != _rateDivisor;
+
+        if ( held != wire.held )
+        {
+            // move the wire's reference over to the other kind
+            wire.fromComponent->_DecRefs( wire.fromOutput, wire.held );
+            wire.fromComponent->_IncRefs( wire.fromOutput, held );
+            wire.held = held;
+        }
+    }
+}
+
+inline void Component::SetLazyInputs_( bool lazyInputs )
+{
+    _lazyInputs = lazyInputs;
+}
+
+inline void Component::SetInputPolicy_( int inputNo, InputPolicy policy )
+{
+    if ( inputNo < 0 || inputNo >= (int)_inputPolicies.size() )
+    {
+        return;
+    }
+
+    _inputPolicies[inputNo] = policy;
+    _hasInputPolicies = std::any_of( _inputPolicies.begin(), _inputPolicies.end(), []( auto inputPolicy ) {
+        return inputPolicy != InputPolicy::Optional;
+    } );
+}
+
 inline void Component::_WaitForRelease( int bufferNo )
 {
+    DSPATCH_PROBE( release_wait_begin, this, bufferNo );
+
     _releaseFlags[bufferNo].WaitAndClear();
+
+    DSPATCH_PROBE( release_wait_end, this, bufferNo );
 }
 
 inline void Component::_ReleaseNextBuffer( int bufferNo )
@@ -536,83 +1347,698 @@ inline void Component::_ReleaseNextBuffer( int bufferNo )
     }
 }
 
-inline void Component::_GetOutput( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus )
+template <typename ComponentType>
+inline void Component::_CallProcess( DSPatch::SignalBus& inputBus, DSPatch::SignalBus& outputBus )
 {
-    auto& signal = *_outputBuses[bufferNo].GetSignal( fromOutput );
+    // You might be thinking: Why not call every class's Process_() directly?
 
-    if ( !signal.has_value() )
+    // A class that isn't final could be derived from again, and its Process_() overridden, so only a
+    // final class's Process_() can be bound statically. That Process_() must also be reachable from
+    // here (E.g. by the class befriending Component). Any other class's Process_() is called virtually.
+
+    if constexpr ( std::is_final_v<ComponentType> && decltype( _CanProcessDirectly<ComponentType>( 0 ) )::value )
     {
+        static_cast<ComponentType*>( this )->Process_( inputBus, outputBus );
+    }
+    else
+    {
+        Process_( inputBus, outputBus );
+    }
+}
+
+template <typename ComponentType>
+inline void Component::_Process( int bufferNo, DSPatch::SignalBus& inputBus, DSPatch::SignalBus& outputBus )
+{
+    // counters are per thread, so the delta across this call belongs to this component alone
+    PerfCounters::Counts countsBefore;
+    const bool countPerf = _perfCountersEnabled && PerfCounters::Read( countsBefore );
+
+    DSPATCH_PROBE( process_begin, this, bufferNo );
+
+    if ( !_hasInputPolicies )
+    {
+        _CallProcess<ComponentType>( inputBus, outputBus );
+#ifdef DSPATCH_SIGNAL_METADATA
+        _StampOutputs( bufferNo, inputBus, outputBus );
+#endif
+    }
+    else
+    {
+        _ProcessWithPolicies<ComponentType>( bufferNo, inputBus, outputBus );
+    }
+
+    DSPATCH_PROBE( process_end, this, bufferNo );
+
+    if ( countPerf )
+    {
+        PerfCounters::Counts countsAfter;
+        if ( PerfCounters::Read( countsAfter ) )
+        {
+            _perfCounts[bufferNo] += countsAfter - countsBefore;
+        }
+    }
+
+    if ( _memoryBudget )
+    {
+        _AccountOutputs( bufferNo, outputBus );
+    }
+
+    if ( _hasHeldRefs )
+    {
+        _HoldOutputs( outputBus );
+    }
+
+    // You might be thinking: Why is EOS updated after Process_() rather than before?
+
+    // Our EOS flag for this buffer is only read by components further down the circuit, and only
+    // once we've finished this tick (they wait on us before fetching their inputs). By then, the
+    // outputs we've just set (our last, if we've reached EOS) are on their way to them too.
+
+    if ( !_endOfStream[bufferNo] )
+    {
+        _endOfStream[bufferNo] = _endOfStreamSet.load( std::memory_order_relaxed ) || _InputsEnded( bufferNo );
+
+        if ( _endOfStream[bufferNo] && _hasHeldRefs )
+        {
+            _heldEndOfStream.store( true, std::memory_order_release );
+        }
+    }
+}
+
+inline void Component::_AccountOutputs( int bufferNo, DSPatch::SignalBus& outputBus )
+{
+    auto& outputBytes = _outputBytes[bufferNo];
+    const int outputCount = outputBus.GetSignalCount();
+
+    // release payloads of outputs that no longer exist
+    for ( int i = outputCount; i < (int)outputBytes.size(); ++i )
+    {
+        _memoryBudget->Release( outputBytes[i] );
+    }
+    outputBytes.resize( outputCount, 0 );
+
+    for ( int i = 0; i < outputCount; ++i )
+    {
+        // our last payload for this output (if not moved on since) was cleared at the start of this tick, so swap it for the new
+        // (a payload fanned out to several wires is copied for all but the last, so it's accounted once per wire)
+        const auto bytes = outputBus.GetSignalSize( i ) * std::max( 1, _refs[bufferNo][i].total );
+
+        if ( bytes == 0 && outputBytes[i] == 0 )
+        {
+            continue;
+        }
+
+        if ( _memoryBudget->Acquire( bytes, outputBytes[i] ) )
+        {
+            outputBytes[i] = bytes;
+        }
+        else
+        {
+            // drop the payload, so this output's wires carry no value this tick
+            outputBus.GetSignal( i )->reset();
+            outputBytes[i] = 0;
+        }
+    }
+}
+
+inline void Component::_ReleaseOutput( int bufferNo, int outputNo )
+{
+    // You might be thinking: Why release a payload that's still in use downstream?
+
+    // A moved payload is accounted by whichever component sets it in its outputs next, so releasing
+    // it here keeps a payload travelling along a chain of components from being counted at every hop.
+
+    auto& outputBytes = _outputBytes[bufferNo];
+
+    if ( outputNo < (int)outputBytes.size() )
+    {
+        _memoryBudget->Release( outputBytes[outputNo] );
+        outputBytes[outputNo] = 0;
+    }
+}
+
+template <typename ComponentType>
+inline void Component::_ProcessWithPolicies( int bufferNo, DSPatch::SignalBus& inputBus, DSPatch::SignalBus& outputBus )
+{
+    // in-order components process one buffer at a time, so they can all share the same held inputs (see _HandOverHeldInputs())
+    auto& heldInputs = _heldInputs[_processOrder == ProcessOrder::InOrder ? 0 : bufferNo];
+
+    bool ready = true;
+
+    for ( int i = 0; i < (int)_inputPolicies.size(); ++i )
+    {
+        // (optional inputs are left alone, so that lazy inputs aren't fetched here unnecessarily)
+        if ( _inputPolicies[i] == InputPolicy::Optional )
+        {
+            continue;
+        }
+
+        inputBus.Fetch( i );
+
+        if ( inputBus.HasValue( i ) )
+        {
+            continue;
+        }
+
+        if ( _inputPolicies[i] == InputPolicy::HoldLast )
+        {
+            // no new value, so lend the held value to the input (swapped back after Process_())
+            inputBus.MoveSignal( i, heldInputs, i );
+        }
+        else if ( _inputPolicies[i] == InputPolicy::Required )
+        {
+            ready = false;
+        }
+    }
+
+    if ( ready )
+    {
+        _CallProcess<ComponentType>( inputBus, outputBus );
+#ifdef DSPATCH_SIGNAL_METADATA
+        // (stamped before held inputs are swapped back out below)
+        _StampOutputs( bufferNo, inputBus, outputBus );
+#endif
+    }
+
+    if ( _heldInputsHandedOver[bufferNo] )
+    {
+        // the next buffer already has copies of our held inputs, and may be using them (see _HandOverHeldInputs())
+        _heldInputsHandedOver[bufferNo] = 0;
         return;
     }
 
+    for ( int i = 0; i < (int)_inputPolicies.size(); ++i )
+    {
+        if ( _inputPolicies[i] == InputPolicy::HoldLast )
+        {
+            // swap the input's value (whether new or lent) into the held inputs
+            heldInputs.MoveSignal( i, inputBus, i );
+        }
+    }
+}
+
+inline void Component::_HandOverHeldInputs( int bufferNo )
+{
+    // You might be thinking: Why copy the held inputs here, rather than swap them back as usual?
+
+    // In-order buffers share their held inputs, each buffer swapping them back after Process_(), before
+    // releasing the next. A buffer that releases the next from within Process_() (E.g. an AsyncComponent
+    // as it suspends) may still be reading its inputs once the next buffer starts. So it leaves the next
+    // buffer copies of the values it would have swapped back, and keeps its own until Process_() returns.
+
+    const auto& inputBus = _inputBuses[bufferNo];
+
+    for ( int i = 0; i < (int)_inputPolicies.size(); ++i )
+    {
+        if ( _inputPolicies[i] == InputPolicy::HoldLast && inputBus.HasValue( i ) )
+        {
+            _heldInputs[0].SetSignal( i, inputBus, i );
+        }
+    }
+
+    _heldInputsHandedOver[bufferNo] = 1;
+}
+
+inline bool Component::_InputsEnded( int bufferNo ) const
+{
+    // a component with no inputs can only end its stream itself
+    // (held wires don't wait on their component's tick, so can't read its per-buffer EOS flags, see _HoldOutputs())
+    return !_inputWires.empty() && std::all_of( _inputWires.begin(), _inputWires.end(), [bufferNo]( const auto& wire ) {
+               return wire.held ? wire.fromComponent->_heldEndOfStream.load( std::memory_order_acquire )
+                                : wire.fromComponent->_endOfStream[bufferNo] != 0;
+           } );
+}
+
+#ifdef DSPATCH_SIGNAL_METADATA
+
+inline void Component::_StampOutputs( int bufferNo, const DSPatch::SignalBus& inputBus, DSPatch::SignalBus& outputBus ) const
+{
+    // You might be thinking: Why not take the origin from the input each output was computed from?
+
+    // Only Process_() knows which inputs an output depends on. Taking the earliest origin among all
+    // inputs gives the worst-case age of an output, which is what a source-to-sink latency measurement
+    // wants. (Lazy inputs Process_() didn't fetch have no origin, so they don't count.)
+
+    // Input metadata is cleared at the start of each tick, so any input with an origin received a signal
+    // this tick. Its origin counts even if Process_() has since moved the signal out (E.g. forwarding it
+    // via MoveSignal( i, *inputs.GetSignal( j ) ), which leaves the input's metadata behind).
+
+    const DSPatch::SignalBus::Metadata* origin = nullptr;
+
+    for ( int i = 0; i < (int)inputBus._metadata.size(); ++i )
+    {
+        const auto& metadata = inputBus._metadata[i];
+
+        if ( metadata.originTime != 0 && ( !origin || metadata.originTime < origin->originTime ) )
+        {
+            origin = &metadata;
+        }
+    }
+
+    DSPatch::SignalBus::Metadata stamp;
+
+    for ( int i = 0; i < (int)outputBus._signals.size(); ++i )
+    {
+        // (outputs given metadata by Process_() keep it)
+        if ( !outputBus._signals[i].has_value() || outputBus._metadata[i].originTime != 0 )
+        {
+            continue;
+        }
+
+        if ( stamp.originTime == 0 )
+        {
+            if ( origin )
+            {
+                stamp = *origin;
+            }
+            else
+            {
+                // no input origin, so our outputs originate here, this tick (_OnRate() has already moved on to our next)
+                stamp.originTime = DSPatch::SignalBus::Metadata::Now();
+                stamp.originTick = _tickNos[bufferNo] >= (uint64_t)_bufferCount ? _tickNos[bufferNo] - _bufferCount : 0;
+            }
+        }
+
+        outputBus._metadata[i] = stamp;
+    }
+}
+
+#endif
+
+inline Component::Transfer Component::_GetOutput( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus )
+{
+    auto& fromBus = _outputBuses[bufferNo];
+
+    if ( !fromBus.GetSignal( fromOutput )->has_value() )
+    {
+        return Transfer::Empty;
+    }
+
     auto& ref = _refs[bufferNo][fromOutput];
 
     if ( ref.total == 1 )
     {
         // there's only one reference, move the signal immediately
-        toBus.MoveSignal( toInput, signal );
+        toBus.MoveSignal( toInput, fromBus, fromOutput );
+        if ( _memoryBudget )
+        {
+            _ReleaseOutput( bufferNo, fromOutput );
+        }
+        return Transfer::Move;
     }
     else if ( ++ref.count != ref.total )
     {
         // this is not the final reference, copy the signal
-        toBus.SetSignal( toInput, signal );
+        toBus.SetSignal( toInput, fromBus, fromOutput );
+        return Transfer::Copy;
     }
     else
     {
         // this is the final reference, reset the counter, move the signal
         ref.count = 0;
-        toBus.MoveSignal( toInput, signal );
+        toBus.MoveSignal( toInput, fromBus, fromOutput );
+        if ( _memoryBudget )
+        {
+            _ReleaseOutput( bufferNo, fromOutput );
+        }
+        return Transfer::Move;
     }
 }
 
-inline void Component::_GetOutputParallel( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus )
+inline Component::Transfer Component::_GetOutputParallel( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus )
 {
-    auto& signal = *_outputBuses[bufferNo].GetSignal( fromOutput );
+    auto& fromBus = _outputBuses[bufferNo];
+    const auto& signal = *fromBus.GetSignal( fromOutput );
     auto& ref = _refs[bufferNo][fromOutput];
 
-    // wait for this output to be ready
-    ref.readyFlag.WaitAndClear();
+    // wait for this output to be ready (thread-local outputs are always ready by the time we get here)
+    if ( !ref.threadLocal )
+    {
+        ref.readyFlag.WaitAndClear();
+    }
+
+    if ( ref.total != 1 && ++ref.count != ref.total )
+    {
+        // this is not the final reference, copy the signal
+        auto transfer = Transfer::Empty;
+
+        if ( signal.has_value() )
+        {
+            toBus.SetSignal( toInput, fromBus, fromOutput );
+            transfer = Transfer::Copy;
+        }
+
+        // wake next WaitAndClear() (even if there's no signal, so that the next reference isn't left waiting)
+        if ( !ref.threadLocal )
+        {
+            ref.readyFlag.Set();
+        }
+        return transfer;
+    }
+
+    // this is the only or final reference, reset the counter, move the signal
+    ref.count = 0;
 
     if ( !signal.has_value() )
+    {
+        return Transfer::Empty;
+    }
+
+    toBus.MoveSignal( toInput, fromBus, fromOutput );
+    if ( _memoryBudget )
+    {
+        _ReleaseOutput( bufferNo, fromOutput );
+    }
+    return Transfer::Move;
+}
+
+inline void Component::_CopyOutput( int bufferNo, int fromOutput, int toInput, DSPatch::SignalBus& toBus )
+{
+    auto& fromBus = _outputBuses[bufferNo];
+
+    if ( fromBus.GetSignal( fromOutput )->has_value() )
+    {
+        toBus.SetSignal( toInput, fromBus, fromOutput );
+    }
+}
+
+inline void Component::_RecordTransfer( int bufferNo, int toInput, Transfer transfer, const DSPatch::SignalBus& toBus )
+{
+    // each buffer keeps its own stats, so no synchronization is required here
+    auto& stats = _transferStats[bufferNo][toInput];
+
+    switch ( transfer )
+    {
+        case Transfer::Empty:
+            ++stats.empties;
+            break;
+        case Transfer::Move:
+            ++stats.moves;
+            break;
+        case Transfer::Copy:
+            ++stats.copies;
+            stats.copiedBytes += toBus.GetSignalSize( toInput );
+            break;
+    }
+}
+
+inline void Component::_DeferInputs( int bufferNo, TickMode tickMode )
+{
+    auto& lazyFetch = _lazyFetches[bufferNo];
+    auto& inputBus = _inputBuses[bufferNo];
+
+    lazyFetch.tickMode = tickMode;
+    lazyFetch.pendingWires.assign( inputBus.GetSignalCount(), nullptr );
+
+    for ( const auto& wire : _inputWires )
+    {
+        lazyFetch.pendingWires[wire.toInput] = &wire;
+    }
+
+    // hook the input bus so that Process_() can fetch its inputs (see SignalBus::Fetch())
+    inputBus._fetch = &_FetchInput;
+    inputBus._fetchContext = &lazyFetch;
+}
+
+inline void Component::_SkipInputs( int bufferNo )
+{
+    auto& lazyFetch = _lazyFetches[bufferNo];
+    auto& inputBus = _inputBuses[bufferNo];
+
+    inputBus._fetch = nullptr;
+    inputBus._fetchContext = nullptr;
+
+    if ( lazyFetch.tickMode == TickMode::Detached )
     {
         return;
     }
 
-    if ( ref.total == 1 )
+    for ( auto wire : lazyFetch.pendingWires )
     {
-        // there's only one reference, move the signal immediately and return
-        toBus.MoveSignal( toInput, signal );
+        // (held wires take no part in reference counting)
+        if ( !wire || wire->held )
+        {
+            continue;
+        }
+
+        // take our turn at the output without taking its signal, so that its other references still copy / move as usual
+        if ( lazyFetch.tickMode == TickMode::Series )
+        {
+            wire->fromComponent->_SkipOutput( bufferNo, wire->fromOutput );
+        }
+        else
+        {
+            wire->fromComponent->_SkipOutputParallel( bufferNo, wire->fromOutput );
+        }
     }
-    else if ( ++ref.count != ref.total )
+}
+
+inline void Component::_FetchInput( void* lazyFetch, int inputNo )
+{
+    auto& fetch = *static_cast<LazyFetch*>( lazyFetch );
+
+    if ( inputNo < 0 || inputNo >= (int)fetch.pendingWires.size() || !fetch.pendingWires[inputNo] )
     {
-        // this is not the final reference, copy the signal
-        toBus.SetSignal( toInput, signal );
+        return;
+    }
 
-        // wake next WaitAndClear()
-        ref.readyFlag.Set();
+    const auto& wire = *fetch.pendingWires[inputNo];
+    fetch.pendingWires[inputNo] = nullptr;
+
+    auto component = fetch.component;
+    auto& inputBus = component->_inputBuses[fetch.bufferNo];
+
+    switch ( fetch.tickMode )
+    {
+        case TickMode::Series:
+        {
+            auto transfer = wire.held ? wire.fromComponent->_GetHeldOutput( wire.fromOutput, wire.toInput, inputBus )
+                                      : wire.fromComponent->_GetOutput( fetch.bufferNo, wire.fromOutput, wire.toInput, inputBus );
+            if ( component->_transferStatsEnabled )
+            {
+                component->_RecordTransfer( fetch.bufferNo, wire.toInput, transfer, inputBus );
+            }
+            break;
+        }
+        case TickMode::Parallel:
+        {
+            auto transfer = wire.held ? wire.fromComponent->_GetHeldOutput( wire.fromOutput, wire.toInput, inputBus )
+                                      : wire.fromComponent->_GetOutputParallel( fetch.bufferNo, wire.fromOutput, wire.toInput, inputBus );
+            if ( component->_transferStatsEnabled )
+            {
+                component->_RecordTransfer( fetch.bufferNo, wire.toInput, transfer, inputBus );
+            }
+            break;
+        }
+        case TickMode::Detached:
+            wire.fromComponent->_CopyOutput( fetch.bufferNo, wire.fromOutput, wire.toInput, inputBus );
+            break;
     }
-    else
+}
+
+inline void Component::_SkipOutput( int bufferNo, int fromOutput )
+{
+    // an empty output isn't counted by _GetOutput() either, so skipping it mustn't count it here
+    if ( !_outputBuses[bufferNo].GetSignal( fromOutput )->has_value() )
+    {
+        return;
+    }
+
+    auto& ref = _refs[bufferNo][fromOutput];
+
+    // the final reference resets the counter (the signal itself is cleared on our next tick)
+    if ( ref.total != 1 && ++ref.count == ref.total )
     {
-        // this is the final reference, reset the counter, move the signal
         ref.count = 0;
-        toBus.MoveSignal( toInput, signal );
     }
 }
 
-inline void Component::_IncRefs( int output )
+inline void Component::_SkipOutputParallel( int bufferNo, int fromOutput )
 {
+    // (unlike _SkipOutput(), an empty output is counted here, just as _GetOutputParallel() counts it, as every reference must
+    // pass on the ready flag)
+
+    auto& ref = _refs[bufferNo][fromOutput];
+
+    if ( !ref.threadLocal )
+    {
+        ref.readyFlag.WaitAndClear();
+    }
+
+    if ( ref.total != 1 && ++ref.count != ref.total )
+    {
+        // wake next WaitAndClear()
+        if ( !ref.threadLocal )
+        {
+            ref.readyFlag.Set();
+        }
+        return;
+    }
+
+    // this is the only or final reference, reset the counter
+    ref.count = 0;
+}
+
+inline void Component::_IncRefs( int output, bool held )
+{
+    if ( held )
+    {
+        if ( output >= (int)_heldRefCounts.size() )
+        {
+            _heldRefCounts.resize( output + 1 );
+            _heldOutputs[0].SetSignalCount( output + 1 );
+            _heldOutputs[1].SetSignalCount( output + 1 );
+        }
+
+        ++_heldRefCounts[output];
+        _hasHeldRefs = true;
+        return;
+    }
+
     for ( auto& ref : _refs )
     {
         ++ref[output].total;
     }
 }
 
-inline void Component::_DecRefs( int output )
+inline void Component::_DecRefs( int output, bool held )
 {
+    if ( held )
+    {
+        if ( output < (int)_heldRefCounts.size() && --_heldRefCounts[output] == 0 )
+        {
+            _heldOutputs[0].GetSignal( output )->reset();
+            _heldOutputs[1].GetSignal( output )->reset();
+            _hasHeldRefs = std::any_of( _heldRefCounts.begin(), _heldRefCounts.end(), []( int count ) { return count != 0; } );
+        }
+        return;
+    }
+
     for ( auto& ref : _refs )
     {
-        --ref[output].total;
+        // the output may have already been removed (see ApplyIORequests())
+        if ( output < (int)ref.size() )
+        {
+            --ref[output].total;
+        }
     }
 }
 
+inline bool Component::_OnRate( int bufferNo )
+{
+    // each buffer takes every _bufferCount'th circuit tick
+    const auto tickNo = _tickNos[bufferNo];
+    _tickNos[bufferNo] += _bufferCount;
+
+    return _rateDivisor == 1 || tickNo % _rateDivisor == 0;
+}
+
+inline void Component::_SkipTick( int bufferNo )
+{
+    // You might be thinking: Why not just return from an off-rate tick?
+
+    // Almost. Our same-rate references are off-rate too, so nothing reads our buses this tick, but an
+    // in-order component must still take its turn in the buffer release order, otherwise the buffer
+    // after this one would wait forever for its turn to process.
+
+    if ( _bufferCount != 1 && _processOrder == ProcessOrder::InOrder )
+    {
+        _WaitForRelease( bufferNo );
+        _ReleaseNextBuffer( bufferNo );
+    }
+}
+
+inline void Component::_HoldOutputs( DSPatch::SignalBus& outputBus )
+{
+    // You might be thinking: Why not have held wires just read our output bus like any other wire?
+
+    // Between our ticks, our outputs can be moved out by our same-rate references, and (when multi-
+    // buffered) our latest outputs are in whichever buffer last ticked on-rate, while other buffers
+    // hold older ones. So our latest outputs are copied here instead, for held wires to read from any
+    // buffer until our next on-rate tick.
+
+    // Held wires read whenever their own component ticks, so they copy from the front held outputs
+    // while we fill in the back, then swap. We only wait for readers still copying from the back
+    // (those that started before our last swap), which never takes longer than a copy.
+
+    const int heldCount = std::min( (int)_heldRefCounts.size(), outputBus.GetSignalCount() );
+
+    // (an output with no value this tick keeps holding its last value, so there may be nothing to swap in)
+    bool hasValues = false;
+    for ( int i = 0; i < heldCount && !hasValues; ++i )
+    {
+        hasValues = _heldRefCounts[i] != 0 && outputBus.HasValue( i );
+    }
+
+    if ( !hasValues )
+    {
+        return;
+    }
+
+    while ( _heldWriting.test_and_set( std::memory_order_acquire ) )
+    {
+        std::this_thread::yield();
+    }
+
+    const int front = _heldFront.load( std::memory_order_relaxed );
+    const int back = 1 - front;
+
+    while ( _heldReaders[back].load( std::memory_order_seq_cst ) != 0 )
+    {
+        std::this_thread::yield();
+    }
+
+    for ( int i = 0; i < heldCount; ++i )
+    {
+        if ( _heldRefCounts[i] == 0 )
+        {
+            continue;
+        }
+
+        if ( outputBus.HasValue( i ) )
+        {
+            _heldOutputs[back].SetSignal( i, outputBus, i );
+        }
+        else
+        {
+            _heldOutputs[back].SetSignal( i, _heldOutputs[front], i );
+        }
+    }
+
+    _heldFront.store( back, std::memory_order_seq_cst );
+
+    _heldWriting.clear( std::memory_order_release );
+}
+
+inline Component::Transfer Component::_GetHeldOutput( int fromOutput, int toInput, DSPatch::SignalBus& toBus )
+{
+    // register as a reader of the front held outputs (retrying if they're swapped for the back in the meantime)
+    int front = _heldFront.load( std::memory_order_seq_cst );
+    for ( ;; )
+    {
+        _heldReaders[front].fetch_add( 1, std::memory_order_seq_cst );
+
+        const int current = _heldFront.load( std::memory_order_seq_cst );
+        if ( current == front )
+        {
+            break;
+        }
+
+        _heldReaders[front].fetch_sub( 1, std::memory_order_release );
+        front = current;
+    }
+
+    auto transfer = Transfer::Empty;
+
+    if ( _heldOutputs[front].GetSignal( fromOutput )->has_value() )
+    {
+        toBus.SetSignal( toInput, _heldOutputs[front], fromOutput );
+        transfer = Transfer::Copy;
+    }
+
+    _heldReaders[front].fetch_sub( 1, std::memory_order_release );
+
+    return transfer;
+}
+
 }  // namespace DSPatch
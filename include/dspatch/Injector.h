@@ -0,0 +1,269 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#include "Component.h"
+#include "RingBuffer.h"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace DSPatch
+{
+
+/// Source component fed from outside the circuit
+
+/**
+An Injector is a built-in source component that bridges data produced by an external thread (E.g. a network receive loop) into a
+circuit. Values are handed to the Injector via Push() from any number of producer threads, queued in a lock-free RingBuffer, and
+emitted one per tick from the Injector's single output.
+
+Movable payloads are moved into and out of the ring, so they pass from the producer to the circuit without being copied.
+
+The behaviour of the Injector when its ring is empty on a tick is configured via EmptyPolicy:
+    - EmptyPolicy::EmitNothing - Output nothing for this tick (downstream components receive a null input).
+    - EmptyPolicy::RepeatLast - Output a copy of the last value received (if any).
+    - EmptyPolicy::Block - Hold up the tick (sleeping) until a value is pushed (or Close() is called).
+
+The behaviour of Push() when the ring is full is configured via FullPolicy:
+    - FullPolicy::Block - Wait (sleeping) for the circuit to make space in the ring.
+    - FullPolicy::Drop - Discard the new value (Push() returns false).
+
+An Injector reports itself idle while its ring is empty, and wakes its circuit whenever a value is pushed, so a circuit ticking in
+Circuit::AutoTickMode::IdleAware only ticks when there's data to process.
+
+<b>NOTE:</b> With EmptyPolicy::Block, a tick (and therefore PauseAutoTick() / StopAutoTick()) will not complete until the next
+value is pushed, so producers should call Close() when they're done.
+
+Only the blocking policies wait on a mutex and condition variable, and only while the ring is empty (or full). Otherwise, pushes
+and pops stay lock-free.
+*/
+
+template <typename ValueType>
+class Injector final : public Component
+{
+public:
+    enum class EmptyPolicy
+    {
+        EmitNothing,
+        RepeatLast,
+        Block
+    };
+
+    enum class FullPolicy
+    {
+        Block,
+        Drop
+    };
+
+    explicit Injector( size_t capacity, EmptyPolicy emptyPolicy = EmptyPolicy::EmitNothing, FullPolicy fullPolicy = FullPolicy::Drop );
+
+    bool Push( ValueType&& value );
+    bool Push( const ValueType& value );
+
+    void Close();
+    bool IsClosed() const;
+
+protected:
+    void Process_( SignalBus&, SignalBus& outputs ) override;
+
+    bool IsIdle_() const override;
+
+private:
+    template <typename T>
+    bool _Push( T&& value );
+
+    template <typename ReadyFn>
+    void _Wait( ReadyFn&& ready );
+    void _Notify();
+
+    const EmptyPolicy _emptyPolicy;
+    const FullPolicy _fullPolicy;
+
+    RingBuffer<ValueType> _ring;
+
+    std::atomic<bool> _closed = { false };
+
+    std::mutex _waitMutex;
+    std::condition_variable _waitCondt;
+    std::atomic<int> _waiting = { 0 };
+
+    ValueType _value{};
+    bool _hasLastValue = false;
+};
+
+template <typename ValueType>
+inline Injector<ValueType>::Injector( size_t capacity, EmptyPolicy emptyPolicy, FullPolicy fullPolicy )
+    : _emptyPolicy( emptyPolicy )
+    , _fullPolicy( fullPolicy )
+    , _ring( capacity )
+{
+    SetOutputCount_( 1 );
+}
+
+template <typename ValueType>
+inline bool Injector<ValueType>::Push( ValueType&& value )
+{
+    return _Push( std::move( value ) );
+}
+
+template <typename ValueType>
+inline bool Injector<ValueType>::Push( const ValueType& value )
+{
+    return _Push( value );
+}
+
+template <typename ValueType>
+inline void Injector<ValueType>::Close()
+{
+    _closed.store( true, std::memory_order_release );
+    _Notify();
+    Wake_();
+}
+
+template <typename ValueType>
+inline bool Injector<ValueType>::IsClosed() const
+{
+    return _closed.load( std::memory_order_acquire );
+}
+
+template <typename ValueType>
+inline void Injector<ValueType>::Process_( SignalBus&, SignalBus& outputs )
+{
+    if ( _ring.TryPop( _value ) )
+    {
+        if ( _fullPolicy == FullPolicy::Block )
+        {
+            _Notify();
+        }
+
+        if ( _emptyPolicy == EmptyPolicy::RepeatLast )
+        {
+            // keep hold of the value in case we need to repeat it
+            _hasLastValue = true;
+            outputs.SetValue( 0, _value );
+        }
+        else
+        {
+            outputs.MoveValue( 0, std::move( _value ) );
+        }
+        return;
+    }
+
+    switch ( _emptyPolicy )
+    {
+        case EmptyPolicy::EmitNothing:
+            break;
+        case EmptyPolicy::RepeatLast:
+            if ( _hasLastValue )
+            {
+                outputs.SetValue( 0, _value );
+            }
+            break;
+        case EmptyPolicy::Block:
+        {
+            bool popped = false;
+            _Wait( [this, &popped] { return ( popped = _ring.TryPop( _value ) ) || IsClosed(); } );
+            if ( popped )
+            {
+                if ( _fullPolicy == FullPolicy::Block )
+                {
+                    _Notify();
+                }
+                outputs.MoveValue( 0, std::move( _value ) );
+            }
+            break;
+        }
+    }
+}
+
+template <typename ValueType>
+inline bool Injector<ValueType>::IsIdle_() const
+{
+    return _ring.IsEmpty();
+}
+
+template <typename ValueType>
+template <typename T>
+inline bool Injector<ValueType>::_Push( T&& value )
+{
+    bool pushed = _ring.TryPush( std::forward<T>( value ) );
+
+    if ( !pushed && _fullPolicy == FullPolicy::Block )
+    {
+        // wait for the circuit to make space in the ring
+        _Wait( [this, &value, &pushed] { return ( pushed = _ring.TryPush( std::forward<T>( value ) ) ) || IsClosed(); } );
+    }
+
+    if ( pushed )
+    {
+        if ( _emptyPolicy == EmptyPolicy::Block )
+        {
+            _Notify();
+        }
+        Wake_();
+    }
+
+    return pushed;
+}
+
+template <typename ValueType>
+template <typename ReadyFn>
+inline void Injector<ValueType>::_Wait( ReadyFn&& ready )
+{
+    // You might be thinking: Why not just wait on _waitCondt from the start?
+
+    // The ring is lock-free, so neither side takes _waitMutex to push or pop. Instead, a waiter
+    // announces itself via _waiting before its last check of the ring, and the other side checks
+    // _waiting after its push / pop (fences on both sides order the two). Either the waiter sees the
+    // change, or the other side sees the waiter and notifies it under the mutex.
+
+    std::unique_lock<std::mutex> lock( _waitMutex );
+
+    _waiting.fetch_add( 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    _waitCondt.wait( lock, ready );
+
+    _waiting.fetch_sub( 1, std::memory_order_relaxed );
+}
+
+template <typename ValueType>
+inline void Injector<ValueType>::_Notify()
+{
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+
+    if ( _waiting.load( std::memory_order_relaxed ) != 0 )
+    {
+        std::lock_guard<std::mutex> lock( _waitMutex );
+        _waitCondt.notify_all();
+    }
+}
+
+}  // namespace DSPatch
@@ -0,0 +1,180 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace DSPatch
+{
+
+/// Payload memory budget
+
+/**
+A MemoryBudget caps the approximate number of bytes of signal payload held in component outputs across a circuit (or across
+several circuits sharing the same budget). Payload sizes are measured via SignalBus size hooks (see SignalBus::SetSizeHook()), so
+only value types with a registered hook count towards the budget. A payload fanned out to several wires counts once per wire, as
+each wire but the last receives a copy.
+
+Once the budget is exceeded, its Policy decides what happens:
+    - Policy::Throttle - The circuit's auto-tick thread slows down (see Circuit::StartAutoTick()) until usage is back within the
+    limit.
+    - Policy::Drop - New payloads that would exceed the limit are dropped from the outputs that produced them, so their wires
+    carry no value that tick. Usage never exceeds the limit.
+    - Policy::Notify - Nothing is done beyond calling the exceeded callback.
+
+In all cases, the exceeded callback (if given) is called each time the budget goes from within its limit to exceeding it. The
+callback is called from whichever circuit thread caused the overrun, so it must be thread-safe and should return quickly.
+*/
+
+class MemoryBudget final
+{
+public:
+    MemoryBudget( const MemoryBudget& ) = delete;
+    MemoryBudget& operator=( const MemoryBudget& ) = delete;
+
+    enum class Policy
+    {
+        Throttle,
+        Drop,
+        Notify
+    };
+
+    MemoryBudget( size_t limit, Policy policy, const std::function<void( size_t usage )>& exceededCallback = nullptr );
+
+    size_t GetLimit() const;
+    Policy GetPolicy() const;
+
+    size_t GetUsage() const;
+    bool IsExceeded() const;
+
+    uint64_t GetDropCount() const;
+
+    bool Acquire( size_t bytes, size_t releasedBytes = 0 );
+    void Release( size_t bytes );
+
+private:
+    const size_t _limit;
+    const Policy _policy;
+    const std::function<void( size_t )> _exceededCallback;
+
+    std::atomic<size_t> _usage = 0;
+    std::atomic<bool> _dropping = false;
+    std::atomic<uint64_t> _dropCount = 0;
+};
+
+inline MemoryBudget::MemoryBudget( size_t limit, Policy policy, const std::function<void( size_t )>& exceededCallback )
+    : _limit( limit )
+    , _policy( policy )
+    , _exceededCallback( exceededCallback )
+{
+}
+
+inline size_t MemoryBudget::GetLimit() const
+{
+    return _limit;
+}
+
+inline MemoryBudget::Policy MemoryBudget::GetPolicy() const
+{
+    return _policy;
+}
+
+inline size_t MemoryBudget::GetUsage() const
+{
+    return _usage.load( std::memory_order_relaxed );
+}
+
+inline bool MemoryBudget::IsExceeded() const
+{
+    if ( _policy == Policy::Drop )
+    {
+        return _dropping.load( std::memory_order_relaxed );
+    }
+
+    return _usage.load( std::memory_order_relaxed ) > _limit;
+}
+
+inline uint64_t MemoryBudget::GetDropCount() const
+{
+    return _dropCount.load( std::memory_order_relaxed );
+}
+
+inline bool MemoryBudget::Acquire( size_t bytes, size_t releasedBytes )
+{
+    // releasedBytes are released in the same step (E.g. the payload this one replaces), and are released even if this payload
+    // is to be dropped (in which case false is returned)
+
+    auto usage = _usage.load( std::memory_order_relaxed );
+    size_t newUsage;
+    bool drop;
+
+    do
+    {
+        newUsage = usage - releasedBytes + bytes;
+        drop = _policy == Policy::Drop && newUsage > _limit;
+
+        if ( drop )
+        {
+            newUsage -= bytes;
+        }
+    } while ( !_usage.compare_exchange_weak( usage, newUsage, std::memory_order_relaxed ) );
+
+    if ( drop )
+    {
+        _dropCount.fetch_add( 1, std::memory_order_relaxed );
+
+        if ( !_dropping.exchange( true, std::memory_order_relaxed ) && _exceededCallback )
+        {
+            _exceededCallback( newUsage + bytes );
+        }
+
+        return false;
+    }
+
+    if ( _policy == Policy::Drop )
+    {
+        _dropping.store( false, std::memory_order_relaxed );
+    }
+    else if ( newUsage > _limit && usage <= _limit && _exceededCallback )
+    {
+        _exceededCallback( newUsage );
+    }
+
+    return true;
+}
+
+inline void MemoryBudget::Release( size_t bytes )
+{
+    _usage.fetch_sub( bytes, std::memory_order_relaxed );
+}
+
+}  // namespace DSPatch
@@ -0,0 +1,230 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#if defined( DSPATCH_PERF_COUNTERS ) && defined( __linux__ )
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define DSPATCH_PERF_EVENT_OPEN
+#endif
+
+#include <cstdint>
+#include <cstring>
+
+namespace DSPatch
+{
+
+/// Per-thread hardware performance counters
+
+/**
+PerfCounters reads the CPU's hardware performance counters (cycles, instructions, last-level cache misses and branch misses) for
+the calling thread. Counters are opened lazily, once per thread, on the first call to Read() from that thread, and are only
+counted while that thread runs in user space. Deltas between two reads attribute the counted events to the code that ran in
+between (see Component::SetPerfCountersEnabled()).
+
+This is currently only backed by perf_event_open() on Linux. Where counters are unavailable (E.g. other platforms, virtual
+machines without a virtual PMU, or a restrictive perf_event_paranoid setting), Read() returns false and IsAvailable() reports
+false. Individual events that the CPU doesn't support simply read as 0.
+
+Counters are opt-in: define DSPATCH_PERF_COUNTERS to compile them in (this keeps the Linux syscall headers they need out of
+every translation unit that includes DSPatch). Without it, counters are reported as unavailable.
+*/
+
+class PerfCounters final
+{
+public:
+    PerfCounters( const PerfCounters& ) = delete;
+    PerfCounters& operator=( const PerfCounters& ) = delete;
+
+    struct Counts final
+    {
+        uint64_t cycles = 0;
+        uint64_t instructions = 0;
+        uint64_t cacheMisses = 0;
+        uint64_t branchMisses = 0;
+
+        Counts& operator+=( const Counts& rhs );
+        Counts operator-( const Counts& rhs ) const;
+    };
+
+    static bool IsAvailable();
+    static bool Read( Counts& counts );
+
+private:
+    enum Event
+    {
+        Cycles,
+        Instructions,
+        CacheMisses,
+        BranchMisses,
+        EventCount
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    static PerfCounters& _ThreadCounters();
+
+    int _groupFd = -1;
+    int _eventCount = 0;
+    int _fds[EventCount];
+    Event _events[EventCount];  // event per group read value
+};
+
+inline PerfCounters::Counts& PerfCounters::Counts::operator+=( const Counts& rhs )
+{
+    cycles += rhs.cycles;
+    instructions += rhs.instructions;
+    cacheMisses += rhs.cacheMisses;
+    branchMisses += rhs.branchMisses;
+    return *this;
+}
+
+inline PerfCounters::Counts PerfCounters::Counts::operator-( const Counts& rhs ) const
+{
+    Counts counts;
+    counts.cycles = cycles - rhs.cycles;
+    counts.instructions = instructions - rhs.instructions;
+    counts.cacheMisses = cacheMisses - rhs.cacheMisses;
+    counts.branchMisses = branchMisses - rhs.branchMisses;
+    return counts;
+}
+
+inline bool PerfCounters::IsAvailable()
+{
+    return _ThreadCounters()._groupFd != -1;
+}
+
+inline bool PerfCounters::Read( Counts& counts )
+{
+#ifdef DSPATCH_PERF_EVENT_OPEN
+    auto& threadCounters = _ThreadCounters();
+
+    if ( threadCounters._groupFd == -1 )
+    {
+        return false;
+    }
+
+    // with PERF_FORMAT_GROUP, a read of the group leader returns: { nr, values[nr] }
+    uint64_t values[1 + EventCount];
+
+    if ( read( threadCounters._groupFd, values, sizeof( values ) ) < (ssize_t)( sizeof( uint64_t ) * ( 1 + threadCounters._eventCount ) ) )
+    {
+        return false;
+    }
+
+    counts = Counts();
+
+    for ( int i = 0; i < threadCounters._eventCount; ++i )
+    {
+        switch ( threadCounters._events[i] )
+        {
+            case Cycles:
+                counts.cycles = values[1 + i];
+                break;
+            case Instructions:
+                counts.instructions = values[1 + i];
+                break;
+            case CacheMisses:
+                counts.cacheMisses = values[1 + i];
+                break;
+            case BranchMisses:
+                counts.branchMisses = values[1 + i];
+                break;
+            case EventCount:
+                break;
+        }
+    }
+
+    return true;
+#else
+    (void)counts;
+    return false;
+#endif
+}
+
+inline PerfCounters::PerfCounters()
+{
+#ifdef DSPATCH_PERF_EVENT_OPEN
+    const uint64_t configs[EventCount] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                                           PERF_COUNT_HW_BRANCH_MISSES };
+
+    for ( int i = 0; i < EventCount; ++i )
+    {
+        perf_event_attr attr;
+        memset( &attr, 0, sizeof( attr ) );
+        attr.size = sizeof( attr );
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        // count the calling thread (pid 0) on whichever CPU it runs (cpu -1)
+        const int fd = (int)syscall( SYS_perf_event_open, &attr, 0, -1, _groupFd, 0 );
+
+        if ( fd == -1 )
+        {
+            if ( _groupFd == -1 )
+            {
+                return;  // no leader (cycles), so no counters at all
+            }
+            continue;  // this event isn't supported, so leave it out of the group
+        }
+
+        if ( _groupFd == -1 )
+        {
+            _groupFd = fd;
+        }
+
+        _fds[_eventCount] = fd;
+        _events[_eventCount++] = (Event)i;
+    }
+#endif
+}
+
+inline PerfCounters::~PerfCounters()
+{
+#ifdef DSPATCH_PERF_EVENT_OPEN
+    // close the group leader last
+    for ( int i = _eventCount - 1; i >= 0; --i )
+    {
+        close( _fds[i] );
+    }
+#endif
+}
+
+inline PerfCounters& PerfCounters::_ThreadCounters()
+{
+    thread_local PerfCounters threadCounters;
+    return threadCounters;
+}
+
+}  // namespace DSPatch
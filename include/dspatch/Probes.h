@@ -0,0 +1,61 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+/// Static tracepoints
+
+/**
+Where <sys/sdt.h> is available (Linux, with SystemTap's SDT headers installed), DSPatch embeds USDT probes in its tick engine. A
+USDT probe compiles down to a single nop plus an ELF note describing its location and arguments, so it costs nothing until a
+tracer (E.g. bpftrace, perf, or SystemTap) attaches to it. Probes can therefore stay in production builds, and be traced live.
+
+All probes belong to the "dspatch" provider, and take 2 arguments:
+    - tick_begin / tick_end (circuit, buffer number) - Circuit::Tick() (a multi-buffered tick carries on in the background).
+    - process_begin / process_end (component, buffer number) - A component's Process_() call.
+    - release_wait_begin / release_wait_end (component, buffer number) - An in-order component waiting for its turn to process.
+    - optimize_begin / optimize_end (circuit, component count) - Circuit optimization (see Circuit::Optimize()).
+
+E.g. bpftrace -e 'usdt:./app:dspatch:process_begin { @start[tid] = nsecs; }
+                  usdt:./app:dspatch:process_end { @ns[arg0] = hist(nsecs - @start[tid]); }'
+
+Define DSPATCH_NO_USDT to compile all probes out.
+*/
+
+#if !defined( DSPATCH_NO_USDT ) && defined( __linux__ ) && defined( __has_include )
+#if __has_include( <sys/sdt.h> )
+#include <sys/sdt.h>
+#define DSPATCH_USDT
+#endif
+#endif
+
+#ifdef DSPATCH_USDT
+#define DSPATCH_PROBE( name, arg1, arg2 ) DTRACE_PROBE2( dspatch, name, arg1, arg2 )
+#else
+#define DSPATCH_PROBE( name, arg1, arg2 )
+#endif
@@ -0,0 +1,211 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace DSPatch
+{
+
+/// Bounded lock-free ring buffer
+
+/**
+RingBuffer is a fixed capacity FIFO queue that can be pushed to and popped from concurrently without locks. Any number of
+producer threads may push into the same ring, and any number of consumer threads may pop from it (though a single consumer is
+the common case).
+
+The ring is lock-free, not wait-free: some push (or pop) always makes progress, but one that loses a race for a slot to another
+push (or pop) retries, so a thread sharing an end of the ring with others has no bound on its retries.
+
+Values are moved in and out of the ring wherever possible, so a movable payload (E.g. a std::vector) passes through without its
+contents being copied. The requested capacity is rounded up to the next power of 2.
+*/
+
+template <typename ValueType>
+class RingBuffer final
+{
+public:
+    RingBuffer( const RingBuffer& ) = delete;
+    RingBuffer& operator=( const RingBuffer& ) = delete;
+
+    explicit RingBuffer( size_t capacity );
+
+    size_t GetCapacity() const;
+
+    bool TryPush( ValueType&& value );
+    bool TryPush( const ValueType& value );
+
+    bool TryPop( ValueType& value );
+
+    bool IsEmpty() const;
+
+private:
+    struct Cell final
+    {
+        std::atomic<size_t> sequence;
+        ValueType value;
+    };
+
+    template <typename T>
+    bool _Push( T&& value );
+
+    const size_t _mask;
+    std::unique_ptr<Cell[]> _cells;
+
+    alignas( 64 ) std::atomic<size_t> _pushPosition = { 0 };
+    alignas( 64 ) std::atomic<size_t> _popPosition = { 0 };
+};
+
+template <typename ValueType>
+inline RingBuffer<ValueType>::RingBuffer( size_t capacity )
+    : _mask( [capacity] {
+        size_t size = 2;
+        while ( size < capacity )
+        {
+            size <<= 1;
+        }
+        return size - 1;
+    }() )
+    , _cells( new Cell[_mask + 1] )
+{
+    for ( size_t i = 0; i <= _mask; ++i )
+    {
+        _cells[i].sequence.store( i, std::memory_order_relaxed );
+    }
+}
+
+template <typename ValueType>
+inline size_t RingBuffer<ValueType>::GetCapacity() const
+{
+    return _mask + 1;
+}
+
+template <typename ValueType>
+inline bool RingBuffer<ValueType>::TryPush( ValueType&& value )
+{
+    return _Push( std::move( value ) );
+}
+
+template <typename ValueType>
+inline bool RingBuffer<ValueType>::TryPush( const ValueType& value )
+{
+    return _Push( value );
+}
+
+template <typename ValueType>
+inline bool RingBuffer<ValueType>::TryPop( ValueType& value )
+{
+    auto position = _popPosition.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        auto& cell = _cells[position & _mask];
+        auto diff = (intptr_t)cell.sequence.load( std::memory_order_acquire ) - (intptr_t)( position + 1 );
+
+        if ( diff == 0 )
+        {
+            // this cell is full, try claim it
+            if ( _popPosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+            {
+                value = std::move( cell.value );
+
+                // hand the cell back to the producers, one lap ahead
+                cell.sequence.store( position + _mask + 1, std::memory_order_release );
+                return true;
+            }
+        }
+        else if ( diff < 0 )
+        {
+            // the ring is empty
+            return false;
+        }
+        else
+        {
+            // another consumer beat us to it
+            position = _popPosition.load( std::memory_order_relaxed );
+        }
+    }
+}
+
+template <typename ValueType>
+inline bool RingBuffer<ValueType>::IsEmpty() const
+{
+    auto position = _popPosition.load( std::memory_order_relaxed );
+    return (intptr_t)_cells[position & _mask].sequence.load( std::memory_order_acquire ) - (intptr_t)( position + 1 ) < 0;
+}
+
+template <typename ValueType>
+template <typename T>
+inline bool RingBuffer<ValueType>::_Push( T&& value )
+{
+    // You might be thinking: Why sequence numbers and not just head and tail indices?
+
+    // Each cell carries a sequence number that tells us which lap of the ring it is ready for. This
+    // lets producers and consumers claim cells with a single compare-exchange on their own position,
+    // while the cell's sequence (rather than the opposing position) tells them whether the claimed
+    // cell has actually been filled / emptied yet. Producers and consumers therefore never contend on
+    // the same cache line unless the ring is completely full or empty.
+
+    auto position = _pushPosition.load( std::memory_order_relaxed );
+
+    for ( ;; )
+    {
+        auto& cell = _cells[position & _mask];
+        auto diff = (intptr_t)cell.sequence.load( std::memory_order_acquire ) - (intptr_t)position;
+
+        if ( diff == 0 )
+        {
+            // this cell is empty, try claim it
+            if ( _pushPosition.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+            {
+                cell.value = std::forward<T>( value );
+
+                // hand the cell over to the consumers
+                cell.sequence.store( position + 1, std::memory_order_release );
+                return true;
+            }
+        }
+        else if ( diff < 0 )
+        {
+            // the ring is full
+            return false;
+        }
+        else
+        {
+            // another producer beat us to it
+            position = _pushPosition.load( std::memory_order_relaxed );
+        }
+    }
+}
+
+}  // namespace DSPatch
@@ -28,10 +28,21 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include "BorrowedView.h"
+
 #include "../fast_any/any.h"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
 #include <vector>
 
+#ifdef DSPATCH_SIGNAL_METADATA
+#include <chrono>
+#endif
+
 namespace DSPatch
 {
 
@@ -47,6 +58,27 @@ Signals can be dynamically typed at runtime, this means a signal has the ability
 program execution. This is designed such that a SignalBus can hold any number of different typed variables, as well as to allow
 for a variable to dynamically change its type when needed - this can be useful for inputs that accept a number of different data
 types (E.g. Varying sample size in an audio buffer: array of byte / int / float).
+
+The approximate payload size of a signal can be queried via GetSignalSize(). As signals are type-erased, a size hook must first be
+registered for each value type of interest via SetSizeHook() (E.g. returning vector.size() * sizeof(float) for a
+std::vector<float>). Signals of unregistered types report a size of 0. Passing nullptr unregisters a type's size hook. Size hooks
+can be (un)registered at any time, even while circuits are ticking. Each signal of a bus remembers the size hook of the value type
+it last measured, so measuring a signal of the same type again is just a type check and a call to its hook.
+
+Large externally owned blocks of memory can be passed through a circuit without copying via BorrowValue(). This places a
+BorrowedView into the signal, which is shared (rather than copied) on fan-out, and releases the memory back to its owner once the
+last signal holding it is cleared (see BorrowedView).
+
+The inputs of a component with lazy inputs (see Component::SetLazyInputs_()) start out empty on each tick. Such a component must
+call Fetch() on an input to pull its signal from the input's wire before reading it. Fetch() does nothing for inputs that have
+already been fetched, and for buses of components without lazy inputs.
+
+When compiled with DSPATCH_SIGNAL_METADATA defined, each signal also carries a fixed-size Metadata slot: the time the signal
+originated at a source component, and the circuit tick it originated in. Metadata travels with its signal from output to input,
+and can be read in Process_() via GetMetadata() (E.g. to measure source-to-sink latency through a multi-buffered circuit). Setting
+a new value clears a signal's metadata, after which the engine fills it in once Process_() returns: from the earliest originating
+of the component's inputs, or (for a source component) with the current time and tick. A component can also set its outputs'
+metadata explicitly via SetMetadata(). Without DSPATCH_SIGNAL_METADATA, metadata is compiled out entirely.
 */
 
 class SignalBus final
@@ -55,6 +87,16 @@ public:
     SignalBus( const SignalBus& ) = delete;
     SignalBus& operator=( const SignalBus& ) = delete;
 
+#ifdef DSPATCH_SIGNAL_METADATA
+    struct Metadata final
+    {
+        uint64_t originTime = 0;  // steady_clock nanoseconds (0 if not set)
+        uint64_t originTick = 0;
+
+        static uint64_t Now();
+    };
+#endif
+
     SignalBus();
     SignalBus( SignalBus&& );
     ~SignalBus();
@@ -62,6 +104,10 @@ public:
     void SetSignalCount( int signalCount );
     int GetSignalCount() const;
 
+    void ReserveSignals( int signalCount );
+
+    void Fetch( int signalIndex );
+
     fast_any::any* GetSignal( int signalIndex );
 
     bool HasValue( int signalIndex ) const;
@@ -75,21 +121,89 @@ public:
     template <typename ValueType>
     void MoveValue( int signalIndex, ValueType&& newValue );
 
+    template <typename ValueType>
+    void BorrowValue( int signalIndex, const ValueType* data, size_t size, std::function<void()> release );
+
+    template <typename ValueType>
+    const BorrowedView<ValueType>* GetBorrowedValue( int signalIndex ) const;
+
     void SetSignal( int toSignalIndex, const fast_any::any& fromSignal );
     void MoveSignal( int toSignalIndex, fast_any::any& fromSignal );
 
+    void SetSignal( int toSignalIndex, const SignalBus& fromBus, int fromSignalIndex );
+    void MoveSignal( int toSignalIndex, SignalBus& fromBus, int fromSignalIndex );
+
     void ClearAllValues();
 
     fast_any::type_info GetType( int signalIndex ) const;
 
+    size_t GetSignalSize( int signalIndex ) const;
+
+#ifdef DSPATCH_SIGNAL_METADATA
+    const Metadata& GetMetadata( int signalIndex ) const;
+    void SetMetadata( int signalIndex, const Metadata& metadata );
+#endif
+
+    template <typename ValueType>
+    static void SetSizeHook( size_t ( *sizeHook )( const ValueType& ) );
+
+    static size_t GetSize( const fast_any::any& signal );
+
 private:
+    typedef bool ( *Holds_t )( const fast_any::any& );
+    typedef size_t ( *SizeOf_t )( const fast_any::any& );
+
+    template <typename ValueType>
+    struct SizeHook final
+    {
+        static inline std::atomic<size_t ( * )( const ValueType& )> hook = nullptr;
+        static inline bool registered = false;  // (guarded by SizeHooks::mutex)
+
+        static bool Holds( const fast_any::any& signal );
+        static size_t SizeOf( const fast_any::any& signal );
+    };
+
+    struct SizeHooks final
+    {
+        std::mutex mutex;
+        std::vector<std::pair<Holds_t, SizeOf_t>> types;  // value types ever registered (only ever appended to)
+        std::atomic<uint64_t> generation = 1;  // bumped as value types are registered
+    };
+
+    struct SizeOfCache final
+    {
+        fast_any::type_info type{};
+        SizeOf_t sizeOf = nullptr;
+        uint64_t generation = 0;  // (0: never resolved)
+    };
+
+    static SizeHooks& _SizeHooks();
+    static SizeOf_t _FindSizeOf( const fast_any::any& signal );
+
+    friend class Component;
+
+    typedef void ( *Fetch_t )( void*, int );
+
     std::vector<fast_any::any> _signals;
+    mutable std::vector<SizeOfCache> _sizeOfs;  // SizeOfCache per signal (see GetSignalSize())
+
+#ifdef DSPATCH_SIGNAL_METADATA
+    std::vector<Metadata> _metadata;
+#endif
+
+    // set while a component with lazy inputs processes this bus (see Fetch())
+    Fetch_t _fetch = nullptr;
+    void* _fetchContext = nullptr;
 };
 
 inline SignalBus::SignalBus() = default;
 
 inline SignalBus::SignalBus( SignalBus&& rhs )
     : _signals( std::move( rhs._signals ) )
+    , _sizeOfs( std::move( rhs._sizeOfs ) )
+#ifdef DSPATCH_SIGNAL_METADATA
+    , _metadata( std::move( rhs._metadata ) )
+#endif
 {
 }
 
@@ -98,6 +212,10 @@ inline SignalBus::~SignalBus() = default;
 inline void SignalBus::SetSignalCount( int signalCount )
 {
     _signals.resize( signalCount );
+    _sizeOfs.resize( signalCount );
+#ifdef DSPATCH_SIGNAL_METADATA
+    _metadata.resize( signalCount );
+#endif
 }
 
 inline int SignalBus::GetSignalCount() const
@@ -105,6 +223,29 @@ inline int SignalBus::GetSignalCount() const
     return (int)_signals.size();
 }
 
+inline void SignalBus::ReserveSignals( int signalCount )
+{
+    _signals.reserve( signalCount );
+    _sizeOfs.reserve( signalCount );
+#ifdef DSPATCH_SIGNAL_METADATA
+    _metadata.reserve( signalCount );
+#endif
+}
+
+inline void SignalBus::Fetch( int signalIndex )
+{
+    // You might be thinking: Why not have the getters below fetch lazy inputs as they're read?
+
+    // They'd then all have to check for (and call through) a fetch hook on every read, in every
+    // component, just to serve the few components with lazy inputs. Instead, lazy components fetch
+    // explicitly, and everyone else's reads stay a plain index into _signals.
+
+    if ( _fetch )
+    {
+        _fetch( _fetchContext, signalIndex );
+    }
+}
+
 inline fast_any::any* SignalBus::GetSignal( int signalIndex )
 {
     // You might be thinking: Why the raw pointer return here?
@@ -137,17 +278,41 @@ template <typename ValueType>
 inline void SignalBus::SetValue( int signalIndex, const ValueType& newValue )
 {
     _signals[signalIndex].emplace<ValueType>( newValue );
+#ifdef DSPATCH_SIGNAL_METADATA
+    _metadata[signalIndex] = Metadata();
+#endif
 }
 
 template <typename ValueType>
 inline void SignalBus::MoveValue( int signalIndex, ValueType&& newValue )
 {
     _signals[signalIndex].emplace<ValueType>( std::forward<ValueType>( newValue ) );
+#ifdef DSPATCH_SIGNAL_METADATA
+    _metadata[signalIndex] = Metadata();
+#endif
+}
+
+template <typename ValueType>
+inline void SignalBus::BorrowValue( int signalIndex, const ValueType* data, size_t size, std::function<void()> release )
+{
+    _signals[signalIndex].emplace<BorrowedView<ValueType>>( data, size, std::move( release ) );
+#ifdef DSPATCH_SIGNAL_METADATA
+    _metadata[signalIndex] = Metadata();
+#endif
+}
+
+template <typename ValueType>
+inline const BorrowedView<ValueType>* SignalBus::GetBorrowedValue( int signalIndex ) const
+{
+    return _signals[signalIndex].as<BorrowedView<ValueType>>();
 }
 
 inline void SignalBus::SetSignal( int toSignalIndex, const fast_any::any& fromSignal )
 {
     _signals[toSignalIndex].emplace( fromSignal );
+#ifdef DSPATCH_SIGNAL_METADATA
+    _metadata[toSignalIndex] = Metadata();
+#endif
 }
 
 inline void SignalBus::MoveSignal( int toSignalIndex, fast_any::any& fromSignal )
@@ -163,6 +328,26 @@ inline void SignalBus::MoveSignal( int toSignalIndex, fast_any::any& fromSignal
     // and shared back and forth from then on.
 
     _signals[toSignalIndex].swap( fromSignal );
+#ifdef DSPATCH_SIGNAL_METADATA
+    _metadata[toSignalIndex] = Metadata();
+#endif
+}
+
+inline void SignalBus::SetSignal( int toSignalIndex, const SignalBus& fromBus, int fromSignalIndex )
+{
+    _signals[toSignalIndex].emplace( fromBus._signals[fromSignalIndex] );
+#ifdef DSPATCH_SIGNAL_METADATA
+    _metadata[toSignalIndex] = fromBus._metadata[fromSignalIndex];
+#endif
+}
+
+inline void SignalBus::MoveSignal( int toSignalIndex, SignalBus& fromBus, int fromSignalIndex )
+{
+    // (swapped, just like MoveSignal() above, metadata included)
+    _signals[toSignalIndex].swap( fromBus._signals[fromSignalIndex] );
+#ifdef DSPATCH_SIGNAL_METADATA
+    std::swap( _metadata[toSignalIndex], fromBus._metadata[fromSignalIndex] );
+#endif
 }
 
 inline void SignalBus::ClearAllValues()
@@ -171,6 +356,12 @@ inline void SignalBus::ClearAllValues()
     {
         signal.reset();
     }
+#ifdef DSPATCH_SIGNAL_METADATA
+    for ( auto& metadata : _metadata )
+    {
+        metadata = Metadata();
+    }
+#endif
 }
 
 inline fast_any::type_info SignalBus::GetType( int signalIndex ) const
@@ -178,4 +369,121 @@ inline fast_any::type_info SignalBus::GetType( int signalIndex ) const
     return _signals[signalIndex].type();
 }
 
+inline size_t SignalBus::GetSignalSize( int signalIndex ) const
+{
+    // You might be thinking: Why not just call GetSize() here?
+
+    // GetSize() has to search the registered size hooks for the signal's value type, under a lock. The
+    // signals of a bus rarely change type from one tick to the next though, so each remembers the size
+    // hook it found last, and only searches again when its type changes or a new type is registered.
+
+    const auto& signal = _signals[signalIndex];
+
+    if ( !signal.has_value() )
+    {
+        return 0;
+    }
+
+    auto& cache = _sizeOfs[signalIndex];
+    const auto generation = _SizeHooks().generation.load( std::memory_order_acquire );
+
+    if ( cache.generation != generation || !( cache.type == signal.type() ) )
+    {
+        cache.type = signal.type();
+        cache.sizeOf = _FindSizeOf( signal );
+        cache.generation = generation;
+    }
+
+    return cache.sizeOf ? cache.sizeOf( signal ) : 0;
+}
+
+#ifdef DSPATCH_SIGNAL_METADATA
+
+inline const SignalBus::Metadata& SignalBus::GetMetadata( int signalIndex ) const
+{
+    return _metadata[signalIndex];
+}
+
+inline void SignalBus::SetMetadata( int signalIndex, const Metadata& metadata )
+{
+    _metadata[signalIndex] = metadata;
+}
+
+inline uint64_t SignalBus::Metadata::Now()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() )
+        .count();
+}
+
+#endif
+
+template <typename ValueType>
+inline void SignalBus::SetSizeHook( size_t ( *sizeHook )( const ValueType& ) )
+{
+    auto& sizeHooks = _SizeHooks();
+
+    std::lock_guard<std::mutex> lock( sizeHooks.mutex );
+
+    SizeHook<ValueType>::hook.store( sizeHook, std::memory_order_release );
+
+    // (unregistering just clears the hook, so that signals that remember it measure 0 from then on)
+    if ( sizeHook && !SizeHook<ValueType>::registered )
+    {
+        sizeHooks.types.emplace_back( &SizeHook<ValueType>::Holds, &SizeHook<ValueType>::SizeOf );
+        SizeHook<ValueType>::registered = true;
+
+        sizeHooks.generation.fetch_add( 1, std::memory_order_release );
+    }
+}
+
+inline size_t SignalBus::GetSize( const fast_any::any& signal )
+{
+    if ( !signal.has_value() )
+    {
+        return 0;
+    }
+
+    const auto sizeOf = _FindSizeOf( signal );
+
+    return sizeOf ? sizeOf( signal ) : 0;
+}
+
+template <typename ValueType>
+inline bool SignalBus::SizeHook<ValueType>::Holds( const fast_any::any& signal )
+{
+    return signal.as<ValueType>() != nullptr;
+}
+
+template <typename ValueType>
+inline size_t SignalBus::SizeHook<ValueType>::SizeOf( const fast_any::any& signal )
+{
+    const auto* value = signal.as<ValueType>();
+    const auto sizeHook = hook.load( std::memory_order_acquire );
+
+    return value && sizeHook ? sizeHook( *value ) : 0;
+}
+
+inline SignalBus::SizeHooks& SignalBus::_SizeHooks()
+{
+    static SizeHooks sizeHooks;
+    return sizeHooks;
+}
+
+inline SignalBus::SizeOf_t SignalBus::_FindSizeOf( const fast_any::any& signal )
+{
+    auto& sizeHooks = _SizeHooks();
+
+    std::lock_guard<std::mutex> lock( sizeHooks.mutex );
+
+    for ( const auto& type : sizeHooks.types )
+    {
+        if ( type.first( signal ) )
+        {
+            return type.second;
+        }
+    }
+
+    return nullptr;
+}
+
 }  // namespace DSPatch
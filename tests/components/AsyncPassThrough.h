@@ -0,0 +1,107 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#ifdef DSPATCH_COROUTINES
+
+namespace DSPatch
+{
+
+class AsyncPassThrough final : public AsyncComponent
+{
+public:
+    explicit AsyncPassThrough( ProcessOrder processOrder = ProcessOrder::InOrder )
+        : AsyncComponent( processOrder )
+    {
+        SetInputCount_( 1 );
+        SetOutputCount_( 1 );
+    }
+
+    int MaxInFlight() const
+    {
+        return _maxInFlight;
+    }
+
+    int MismatchCount() const
+    {
+        return _mismatchCount;
+    }
+
+protected:
+    Task ProcessAsync_( SignalBus& inputs, SignalBus& outputs ) override
+    {
+        const auto* in = inputs.GetValue<int>( 0 );
+
+        if ( !in )
+        {
+            co_return;
+        }
+
+        const bool inOrder = GetProcessOrder() == ProcessOrder::InOrder;
+
+        // in-order coroutines start in buffer order
+        if ( inOrder && *in != _count++ )
+        {
+            ++_mismatchCount;
+        }
+
+        auto inFlight = ++_inFlight;
+        auto maxInFlight = _maxInFlight.load();
+        while ( inFlight > maxInFlight && !_maxInFlight.compare_exchange_weak( maxInFlight, inFlight ) )
+        {
+        }
+
+        // stand in for a slow service (that answers later buffers sooner, so their waits end out of order)
+        auto value = co_await Await_( std::async( std::launch::async, [value = *in] {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 + 3 - value % 4 ) );
+            return value;
+        } ) );
+
+        // in-order coroutines resume in buffer order too
+        if ( inOrder && value != _resumeCount++ )
+        {
+            ++_mismatchCount;
+        }
+
+        --_inFlight;
+
+        outputs.SetValue( 0, value );
+    }
+
+private:
+    int _count = 0;
+    int _resumeCount = 0;
+    std::atomic<int> _inFlight = 0;
+    std::atomic<int> _maxInFlight = 0;
+    std::atomic<int> _mismatchCount = 0;
+};
+
+}  // namespace DSPatch
+
+#endif  // DSPATCH_COROUTINES
@@ -0,0 +1,91 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+#ifdef DSPATCH_SIGNAL_METADATA
+
+namespace DSPatch
+{
+
+class MetadataProbe final : public Component
+{
+public:
+    MetadataProbe()
+    {
+        SetInputCount_( 1 );
+    }
+
+    int Count() const
+    {
+        return _count;
+    }
+
+    int MismatchCount() const
+    {
+        return _mismatchCount;
+    }
+
+    uint64_t MinAge() const
+    {
+        return _minAge;
+    }
+
+protected:
+    void Process_( SignalBus& inputs, SignalBus& ) override
+    {
+        // each value from a counter should carry the tick it originated in, and a time no later than now
+        const auto* in = inputs.GetValue<int>( 0 );
+
+        if ( in )
+        {
+            const auto& metadata = inputs.GetMetadata( 0 );
+
+            const auto now = SignalBus::Metadata::Now();
+
+            if ( metadata.originTick != (uint64_t)*in || metadata.originTime == 0 || metadata.originTime > now )
+            {
+                ++_mismatchCount;
+            }
+            else
+            {
+                _minAge = std::min( _minAge, now - metadata.originTime );
+            }
+            ++_count;
+        }
+    }
+
+private:
+    int _count = 0;
+    int _mismatchCount = 0;
+    uint64_t _minAge = UINT64_MAX;
+};
+
+}  // namespace DSPatch
+
+#endif  // DSPATCH_SIGNAL_METADATA
@@ -36,23 +36,36 @@ class NoOutputProbe final : public Component
 public:
     NoOutputProbe()
         : _count( 0 )
+        , _mismatchCount( 0 )
     {
         SetInputCount_( 1 );
     }
 
+    int Count() const
+    {
+        return _count;
+    }
+
+    int MismatchCount() const
+    {
+        return _mismatchCount;
+    }
+
 protected:
     void Process_( SignalBus& inputs, SignalBus& ) override
     {
         const auto* in = inputs.GetValue<int>( 0 );
 
-        if ( in )
+        // (this may run on a circuit thread, where REQUIRE() can't report, so mismatches are counted for the test to check)
+        if ( in && *in != _count++ )
         {
-            REQUIRE( *in == _count++ );
+            ++_mismatchCount;
         }
     }
 
 private:
-    int _count;
+    std::atomic<int> _count;
+    std::atomic<int> _mismatchCount;
 };
 
 }  // namespace DSPatch
@@ -33,6 +33,8 @@ namespace DSPatch
 
 class PassThrough final : public Component
 {
+    friend class DSPatch::Component;  // (lets the engine call Process_() directly)
+
 public:
     PassThrough()
         : Component( ProcessOrder::OutOfOrder )
@@ -0,0 +1,100 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+namespace DSPatch
+{
+
+class PolicyProbe final : public Component
+{
+public:
+    explicit PolicyProbe( bool releaseEarly = false )
+        : _releaseEarly( releaseEarly )
+    {
+        SetInputCount_( 2 );
+        SetInputPolicy_( 0, InputPolicy::Required );
+        SetInputPolicy_( 1, InputPolicy::HoldLast );
+    }
+
+    int Count() const
+    {
+        return _count;
+    }
+
+    int ViolationCount() const
+    {
+        return _violationCount;
+    }
+
+protected:
+    void Process_( SignalBus& inputs, SignalBus& ) override
+    {
+        // required input must always be present
+        const auto* required = inputs.GetValue<int>( 0 );
+        if ( !required || *required <= _lastRequired )
+        {
+            ++_violationCount;
+            return;
+        }
+        _lastRequired = *required;
+
+        // held input must never go missing (or backwards) once it has arrived
+        const auto* held = inputs.GetValue<int>( 1 );
+        if ( held ? *held < _lastHeld : _lastHeld != -1 )
+        {
+            ++_violationCount;
+        }
+        const int lastHeld = held ? *held : -1;
+        _lastHeld = lastHeld;
+
+        ++_count;
+
+        if ( _releaseEarly )
+        {
+            // carry on with our inputs while the next buffer processes (as an AsyncComponent does while it waits)
+            ReleaseNextBuffer_();
+            std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+
+            held = inputs.GetValue<int>( 1 );
+            if ( ( held ? *held : -1 ) != lastHeld )
+            {
+                ++_violationCount;
+            }
+        }
+    }
+
+private:
+    const bool _releaseEarly;
+    std::atomic<int> _count = 0;
+    std::atomic<int> _violationCount = 0;
+    int _lastRequired = -1;
+    int _lastHeld = -1;
+};
+
+}  // namespace DSPatch
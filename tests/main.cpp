@@ -33,6 +33,10 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <catch/catch.hpp>
 
 #include "components/Adder.h"
+#include "components/AlternatingCounter.h"
+#include "components/AsyncPassThrough.h"
+#include "components/BorrowedProbe.h"
+#include "components/BorrowingCounter.h"
 #include "components/BranchSyncProbe.h"
 #include "components/ChangingCounter.h"
 #include "components/ChangingProbe.h"
@@ -41,13 +45,21 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "components/Counter.h"
 #include "components/FeedbackProbe.h"
 #include "components/FeedbackTester.h"
+#include "components/FiniteCounter.h"
+#include "components/GrowingCounter.h"
 #include "components/Incrementer.h"
+#include "components/LazySelector.h"
+#include "components/MetadataProbe.h"
 #include "components/NoOutputProbe.h"
 #include "components/NullInputProbe.h"
 #include "components/ParallelProbe.h"
 #include "components/PassThrough.h"
+#include "components/PolicyProbe.h"
+#include "components/RateRecorder.h"
+#include "components/Resizer.h"
 #include "components/SerialProbe.h"
 #include "components/SlowCounter.h"
+#include "components/SlowPassThrough.h"
 #include "components/SporadicCounter.h"
 #include "components/ThreadingProbe.h"
 
@@ -333,6 +345,8 @@ TEST_CASE( "NoOutputTest" )
     {
         circuit->Tick();
     }
+
+    REQUIRE( probe->MismatchCount() == 0 );
 }
 
 TEST_CASE( "ChangingOutputTest" )
@@ -876,6 +890,1718 @@ TEST_CASE( "AddComponentAfterMultiBufferTickRegressionTest" )
     REQUIRE( counter->Count() == 2 );
 }
 
+TEST_CASE( "AddRemoveComponentUnderAutoTickRegressionTest" )
+{
+    auto circuit = std::make_shared<Circuit>();
+    auto counter = std::make_shared<Counter>();
+    auto passThrough = std::make_shared<PassThrough>();
+    circuit->AddComponent( counter );
+    circuit->AddComponent( passThrough );
+    circuit->ConnectOutToIn( counter, 0, passThrough, 0 );
+
+    circuit->SetBufferCount( 2 );
+    circuit->SetThreadCount( 2 );
+    circuit->SetScheduling( Circuit::Scheduling::Islands );
+    circuit->StartAutoTick();
+
+    // components must be added and removed by handle, even while an auto-tick re-optimizes the circuit
+    for ( int i = 0; i < 100; ++i )
+    {
+        auto extra = std::make_shared<PassThrough>();
+        circuit->AddComponent( extra );
+        circuit->ConnectOutToIn( counter, 0, extra, 0 );
+
+        REQUIRE( circuit->GetComponent( circuit->GetComponentHandle( extra ) ) == extra );
+
+        REQUIRE( circuit->RemoveComponent( extra ) );
+    }
+
+    circuit->StopAutoTick();
+
+    REQUIRE( circuit->GetComponentCount() == 2 );
+    REQUIRE( circuit->GetComponentHandle( counter ) != -1 );
+    REQUIRE( circuit->GetComponentHandle( passThrough ) != -1 );
+}
+
+TEST_CASE( "ScanParallelOrderRegressionTest" )
+{
+    // the adder's last input is on a lower level than its first, and another component follows the adder
+    auto circuit = std::make_shared<Circuit>();
+    auto counter1 = std::make_shared<Counter>();
+    auto counter2 = std::make_shared<Counter>();
+    auto passThrough1 = std::make_shared<PassThrough>();
+    auto passThrough2 = std::make_shared<PassThrough>();
+    auto adder = std::make_shared<Adder>();
+    auto passThrough3 = std::make_shared<PassThrough>();
+
+    circuit->AddComponent( counter1 );
+    circuit->AddComponent( counter2 );
+    circuit->AddComponent( passThrough1 );
+    circuit->AddComponent( passThrough2 );
+    circuit->AddComponent( adder );
+    circuit->AddComponent( passThrough3 );
+
+    circuit->ConnectOutToIn( counter1, 0, passThrough1, 0 );
+    circuit->ConnectOutToIn( passThrough1, 0, passThrough2, 0 );
+    circuit->ConnectOutToIn( passThrough2, 0, adder, 0 );
+    circuit->ConnectOutToIn( counter2, 0, adder, 1 );
+    circuit->ConnectOutToIn( adder, 0, passThrough3, 0 );
+
+    // passThrough3 must be ordered after the adder, else a single thread would wait on the adder forever
+    circuit->SetThreadCount( 1 );
+
+    for ( int i = 0; i < 100; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->Sync();
+
+    REQUIRE( counter1->Count() == 100 );
+}
+
+TEST_CASE( "SizeHookRegressionTest" )
+{
+    fast_any::any signal;
+    signal.emplace<short>( 1 );
+
+    // nullptr neither registers a hook, nor leaves a null hook registered
+    SignalBus::SetSizeHook<short>( nullptr );
+    REQUIRE( SignalBus::GetSize( signal ) == 0 );
+
+    SignalBus::SetSizeHook<short>( []( const short& ) { return sizeof( short ); } );
+    REQUIRE( SignalBus::GetSize( signal ) == sizeof( short ) );
+
+    SignalBus::SetSizeHook<short>( nullptr );
+    REQUIRE( SignalBus::GetSize( signal ) == 0 );
+
+    SignalBus::SetSizeHook<short>( []( const short& ) { return (size_t)42; } );
+    REQUIRE( SignalBus::GetSize( signal ) == 42 );
+
+    SignalBus::SetSizeHook<short>( nullptr );
+
+    // a bus remembers each signal's size hook, but still follows its type changes and hook (un)registrations
+    SignalBus bus;
+    bus.SetSignalCount( 1 );
+
+    bus.SetValue( 0, (char)1 );
+    REQUIRE( bus.GetSignalSize( 0 ) == 0 );
+
+    SignalBus::SetSizeHook<char>( []( const char& ) { return (size_t)7; } );
+    REQUIRE( bus.GetSignalSize( 0 ) == 7 );
+
+    bus.SetValue( 0, (short)1 );
+    REQUIRE( bus.GetSignalSize( 0 ) == 0 );
+
+    bus.SetValue( 0, (char)2 );
+    REQUIRE( bus.GetSignalSize( 0 ) == 7 );
+
+    SignalBus::SetSizeHook<char>( nullptr );
+    REQUIRE( bus.GetSignalSize( 0 ) == 0 );
+}
+
+TEST_CASE( "TransferStatsTest" )
+{
+    SignalBus::SetSizeHook<int>( []( const int& ) { return sizeof( int ); } );
+
+    // Configure a circuit where a counter fans out to 3 pass-throughs, and a sporadic counter feeds a probe
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto pass1 = std::make_shared<PassThrough>();
+    auto pass2 = std::make_shared<PassThrough>();
+    auto pass3 = std::make_shared<PassThrough>();
+    auto sporadic = std::make_shared<SporadicCounter>();
+    auto probe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( pass1 );
+    circuit->AddComponent( pass2 );
+    circuit->AddComponent( pass3 );
+    circuit->AddComponent( sporadic );
+    circuit->AddComponent( probe );
+
+    circuit->ConnectOutToIn( counter, 0, pass1, 0 );
+    circuit->ConnectOutToIn( counter, 0, pass2, 0 );
+    circuit->ConnectOutToIn( counter, 0, pass3, 0 );
+    circuit->ConnectOutToIn( sporadic, 0, probe, 0 );
+
+    circuit->SetTransferStatsEnabled( true );
+
+    for ( int bufferCount = 0; bufferCount <= 2; ++bufferCount )
+    {
+        circuit->SetBufferCount( bufferCount );
+
+        pass1->ResetTransferStats();
+        pass2->ResetTransferStats();
+        pass3->ResetTransferStats();
+        probe->ResetTransferStats();
+
+        // Tick the circuit 100 times
+        for ( int i = 0; i < 100; ++i )
+        {
+            circuit->Tick();
+        }
+        circuit->Sync();
+
+        // 2 of every 3 fan-out transfers are copies, the final one is a move
+        Component::TransferStats fanOut;
+        for ( const auto& pass : { pass1, pass2, pass3 } )
+        {
+            auto stats = pass->GetTransferStats( 0 );
+            fanOut.moves += stats.moves;
+            fanOut.copies += stats.copies;
+            fanOut.empties += stats.empties;
+            fanOut.copiedBytes += stats.copiedBytes;
+        }
+        REQUIRE( fanOut.moves == 100 );
+        REQUIRE( fanOut.copies == 200 );
+        REQUIRE( fanOut.empties == 0 );
+        REQUIRE( fanOut.copiedBytes == 200 * sizeof( int ) );
+
+        // a single reference is always moved (if there's anything to move)
+        auto stats = probe->GetTransferStats( 0 );
+        REQUIRE( stats.moves + stats.empties == 100 );
+        REQUIRE( stats.copies == 0 );
+
+        REQUIRE( probe->MismatchCount() == 0 );
+    }
+
+    circuit->SetTransferStatsEnabled( false );
+    pass1->ResetTransferStats();
+
+    circuit->Tick();
+    circuit->Sync();
+
+    REQUIRE( pass1->GetTransferStats( 0 ).moves + pass1->GetTransferStats( 0 ).copies == 0 );
+}
+
+TEST_CASE( "InjectorTest" )
+{
+    // Configure a circuit where an injector is fed from an external thread
+    auto circuit = std::make_shared<Circuit>();
+
+    auto injector = std::make_shared<Injector<int>>( 16, Injector<int>::EmptyPolicy::EmitNothing, Injector<int>::FullPolicy::Block );
+    auto probe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( injector );
+    circuit->AddComponent( probe );
+
+    circuit->ConnectOutToIn( injector, 0, probe, 0 );
+
+    circuit->SetBufferCount( 2 );
+    circuit->StartAutoTick();
+
+    std::thread producer( [&injector] {
+        for ( int i = 0; i < 1000; ++i )
+        {
+            REQUIRE( injector->Push( i ) );
+        }
+    } );
+    producer.join();
+
+    while ( probe->Count() != 1000 )
+    {
+        std::this_thread::yield();
+    }
+
+    circuit->StopAutoTick();
+
+    REQUIRE( probe->MismatchCount() == 0 );
+
+    // A full injector with FullPolicy::Drop rejects new values
+    auto dropper = std::make_shared<Injector<std::vector<int>>>( 4 );
+    for ( int i = 0; i < 4; ++i )
+    {
+        REQUIRE( dropper->Push( std::vector<int>( 1024, i ) ) );
+    }
+    REQUIRE( !dropper->Push( std::vector<int>( 1024, 4 ) ) );
+
+    // A blocked tick is released on Close()
+    auto blocker = std::make_shared<Injector<int>>( 4, Injector<int>::EmptyPolicy::Block );
+    std::thread closer( [&blocker] {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        blocker->Close();
+    } );
+    blocker->Tick( 0 );
+    closer.join();
+    REQUIRE( blocker->IsClosed() );
+
+    // A blocked tick is released by the next push
+    auto waiter = std::make_shared<Injector<int>>( 4, Injector<int>::EmptyPolicy::Block );
+    auto waiterProbe = std::make_shared<NoOutputProbe>();
+
+    circuit->RemoveAllComponents();
+    circuit->AddComponent( waiter );
+    circuit->AddComponent( waiterProbe );
+    circuit->ConnectOutToIn( waiter, 0, waiterProbe, 0 );
+
+    std::thread pusher( [&waiter] {
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+        waiter->Push( 0 );
+    } );
+    circuit->Tick();
+    circuit->Sync();
+    pusher.join();
+    REQUIRE( waiterProbe->Count() == 1 );
+    REQUIRE( waiterProbe->MismatchCount() == 0 );
+
+    // An injector that outlives its circuit no longer wakes it (that circuit is gone)
+    auto orphan = std::make_shared<Injector<int>>( 4 );
+    {
+        auto orphanCircuit = std::make_shared<Circuit>();
+        orphanCircuit->AddComponent( orphan );
+        orphanCircuit->StartAutoTick( Circuit::AutoTickMode::IdleAware );
+    }
+    REQUIRE( orphan->Push( 0 ) );
+}
+
+TEST_CASE( "InputPolicyTest" )
+{
+    // Configure a circuit where sporadic counters feed a required and a held input
+    auto circuit = std::make_shared<Circuit>();
+
+    auto required = std::make_shared<SporadicCounter>();
+    auto held = std::make_shared<SporadicCounter>();
+    auto probe = std::make_shared<PolicyProbe>();
+    auto earlyProbe = std::make_shared<PolicyProbe>( true );
+
+    circuit->AddComponent( required );
+    circuit->AddComponent( held );
+    circuit->AddComponent( probe );
+    circuit->AddComponent( earlyProbe );
+
+    circuit->ConnectOutToIn( required, 0, probe, 0 );
+    circuit->ConnectOutToIn( held, 0, probe, 1 );
+
+    // an in-order component that releases the next buffer from Process_() must still pass its held inputs on in order
+    circuit->ConnectOutToIn( required, 0, earlyProbe, 0 );
+    circuit->ConnectOutToIn( held, 0, earlyProbe, 1 );
+
+    REQUIRE( probe->GetInputPolicy( 0 ) == Component::InputPolicy::Required );
+    REQUIRE( probe->GetInputPolicy( 1 ) == Component::InputPolicy::HoldLast );
+
+    for ( int bufferCount = 0; bufferCount <= 3; ++bufferCount )
+    {
+        circuit->SetBufferCount( bufferCount );
+
+        // Tick the circuit 100 times
+        for ( int i = 0; i < 100; ++i )
+        {
+            circuit->Tick();
+        }
+        circuit->Sync();
+    }
+
+    // Process_() is only called on ticks where the required input has a value
+    REQUIRE( probe->Count() > 0 );
+    REQUIRE( probe->Count() < 400 );
+    REQUIRE( earlyProbe->Count() == probe->Count() );
+    REQUIRE( probe->ViolationCount() == 0 );
+    REQUIRE( earlyProbe->ViolationCount() == 0 );
+}
+
+TEST_CASE( "TickSubgraphTest" )
+{
+    // Configure a circuit made up of 2 independent counter -> probe branches
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter1 = std::make_shared<Counter>();
+    auto pass1 = std::make_shared<PassThrough>();
+    auto probe1 = std::make_shared<NoOutputProbe>();
+    auto counter2 = std::make_shared<Counter>();
+    auto probe2 = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( counter1 );
+    circuit->AddComponent( pass1 );
+    circuit->AddComponent( probe1 );
+    circuit->AddComponent( counter2 );
+    circuit->AddComponent( probe2 );
+
+    circuit->ConnectOutToIn( counter1, 0, pass1, 0 );
+    circuit->ConnectOutToIn( pass1, 0, probe1, 0 );
+    circuit->ConnectOutToIn( counter2, 0, probe2, 0 );
+
+    for ( int bufferCount = 0; bufferCount <= 2; ++bufferCount )
+    {
+        circuit->SetBufferCount( bufferCount );
+
+        int count1 = counter1->Count();
+        int count2 = counter2->Count();
+
+        // Tick only the first branch
+        for ( int i = 0; i < 10; ++i )
+        {
+            REQUIRE( circuit->TickSubgraph( { probe1 } ) );
+        }
+
+        REQUIRE( counter1->Count() == count1 + 10 );
+        REQUIRE( probe1->Count() == count1 + 10 );
+        REQUIRE( counter2->Count() == count2 );
+        REQUIRE( probe2->Count() == count2 );
+
+        // The full circuit carries on where it left off
+        for ( int i = 0; i < 10; ++i )
+        {
+            circuit->Tick();
+        }
+        circuit->Sync();
+
+        REQUIRE( counter1->Count() == count1 + 20 );
+        REQUIRE( probe1->Count() == count1 + 20 );
+        REQUIRE( counter2->Count() == count2 + 10 );
+        REQUIRE( probe2->Count() == count2 + 10 );
+
+        REQUIRE( probe1->MismatchCount() == 0 );
+        REQUIRE( probe2->MismatchCount() == 0 );
+    }
+
+    // Components outside the circuit are rejected
+    REQUIRE( !circuit->TickSubgraph( { std::make_shared<NoOutputProbe>() } ) );
+}
+
+TEST_CASE( "IslandSchedulingTest" )
+{
+    // Configure a circuit made up of 4 disconnected counter -> pass-through -> probe chains
+    auto circuit = std::make_shared<Circuit>();
+    circuit->SetScheduling( Circuit::Scheduling::Islands );
+
+    std::vector<std::shared_ptr<NoOutputProbe>> probes;
+
+    for ( int i = 0; i < 4; ++i )
+    {
+        auto counter = std::make_shared<Counter>();
+        auto probe = std::make_shared<NoOutputProbe>();
+        circuit->AddComponent( counter );
+        circuit->AddComponent( probe );
+
+        Component::SPtr last = counter;
+        for ( int j = 0; j < 5; ++j )
+        {
+            auto passthrough = std::make_shared<PassThrough>();
+            circuit->AddComponent( passthrough );
+            circuit->ConnectOutToIn( last, 0, passthrough, 0 );
+            last = passthrough;
+        }
+        circuit->ConnectOutToIn( last, 0, probe, 0 );
+
+        probes.emplace_back( probe );
+    }
+
+    circuit->Optimize();
+    REQUIRE( circuit->GetIslandCount() == 4 );
+
+    int tickCount = 0;
+
+    for ( int bufferCount = 0; bufferCount <= 2; bufferCount += 2 )
+    {
+        circuit->SetBufferCount( bufferCount );
+
+        for ( int threadCount = 1; threadCount <= 3; ++threadCount )
+        {
+            circuit->SetThreadCount( threadCount );
+
+            // Tick the circuit 100 times
+            for ( int i = 0; i < 100; ++i )
+            {
+                circuit->Tick();
+            }
+            circuit->Sync();
+
+            tickCount += 100;
+
+            for ( const auto& probe : probes )
+            {
+                REQUIRE( probe->Count() == tickCount );
+                REQUIRE( probe->MismatchCount() == 0 );
+            }
+        }
+    }
+
+    // island tick counts are reset on every re-optimization (E.g. thread count change)
+    for ( int i = 0; i < circuit->GetIslandCount(); ++i )
+    {
+        REQUIRE( circuit->GetIslandTickCount( i ) == 100 );
+    }
+
+    // a newly added component forms a new island
+    circuit->AddComponent( std::make_shared<Counter>() );
+    circuit->Optimize();
+    REQUIRE( circuit->GetIslandCount() == 5 );
+}
+
+TEST_CASE( "ComponentHandleTest" )
+{
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto pass = std::make_shared<PassThrough>();
+    auto probe = std::make_shared<NoOutputProbe>();
+
+    REQUIRE( circuit->AddComponent( counter ) );
+    REQUIRE( circuit->AddComponent( pass ) );
+    REQUIRE( circuit->AddComponent( probe ) );
+
+    int counterHandle = circuit->GetComponentHandle( counter );
+    int passHandle = circuit->GetComponentHandle( pass );
+    int probeHandle = circuit->GetComponentHandle( probe );
+
+    REQUIRE( counterHandle == 0 );
+    REQUIRE( passHandle == 1 );
+    REQUIRE( probeHandle == 2 );
+
+    REQUIRE( !circuit->AddComponent( counter ) );
+    REQUIRE( !circuit->AddComponent( nullptr ) );
+
+    REQUIRE( circuit->GetComponentHandle( pass ) == passHandle );
+    REQUIRE( circuit->GetComponent( passHandle ) == pass );
+    REQUIRE( circuit->GetComponent( 3 ) == nullptr );
+
+    // Wire up the components via handles
+    REQUIRE( circuit->ConnectOutToIn( counterHandle, 0, passHandle, 0 ) );
+    REQUIRE( circuit->ConnectOutToIn( passHandle, 0, probeHandle, 0 ) );
+    REQUIRE( !circuit->ConnectOutToIn( passHandle, 0, 3, 0 ) );
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        circuit->Tick();
+    }
+    REQUIRE( probe->Count() == 10 );
+
+    // Removed handles are recycled
+    REQUIRE( circuit->RemoveComponent( passHandle ) );
+    REQUIRE( !circuit->RemoveComponent( passHandle ) );
+    REQUIRE( circuit->GetComponentHandle( pass ) == -1 );
+    REQUIRE( circuit->GetComponentCount() == 2 );
+
+    auto pass2 = std::make_shared<PassThrough>();
+    REQUIRE( circuit->AddComponent( pass2 ) );
+    REQUIRE( circuit->GetComponentHandle( pass2 ) == passHandle );
+
+    REQUIRE( circuit->ConnectOutToIn( counter, 0, pass2, 0 ) );
+    REQUIRE( circuit->ConnectOutToIn( passHandle, 0, probeHandle, 0 ) );
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        circuit->Tick();
+    }
+    REQUIRE( probe->Count() == 20 );
+
+    REQUIRE( circuit->DisconnectComponent( passHandle ) );
+    circuit->Tick();
+    REQUIRE( probe->Count() == 20 );
+    REQUIRE( probe->MismatchCount() == 0 );
+}
+
+TEST_CASE( "DeepCircuitOptimizeTest" )
+{
+    // Configure a circuit made up of a counter and 5000 pass-throughs in series
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto probe = std::make_shared<NoOutputProbe>();
+    circuit->AddComponent( counter );
+    circuit->AddComponent( probe );
+
+    std::vector<Component::SPtr> passthroughs;
+    for ( int i = 0; i < 5000; ++i )
+    {
+        passthroughs.emplace_back( std::make_shared<PassThrough>() );
+    }
+
+    // add and wire in reverse so that the optimizer has some ordering to do
+    for ( auto it = passthroughs.rbegin(); it != passthroughs.rend(); ++it )
+    {
+        circuit->AddComponent( *it );
+    }
+
+    Component::SPtr last = counter;
+    for ( const auto& passthrough : passthroughs )
+    {
+        circuit->ConnectOutToIn( last, 0, passthrough, 0 );
+        last = passthrough;
+    }
+    circuit->ConnectOutToIn( last, 0, probe, 0 );
+
+    for ( int threadCount = 0; threadCount <= 2; ++threadCount )
+    {
+        circuit->SetThreadCount( threadCount );
+        circuit->Optimize();
+
+        for ( int i = 0; i < 10; ++i )
+        {
+            circuit->Tick();
+        }
+        circuit->Sync();
+
+        REQUIRE( probe->Count() == 10 * ( threadCount + 1 ) );
+        REQUIRE( probe->MismatchCount() == 0 );
+    }
+
+    // a feedback loop can't be levelized, so the optimizer must fall back to scanning
+    auto feedback = std::make_shared<PassThrough>();
+    circuit->SetThreadCount( 0 );
+    circuit->AddComponent( feedback );
+    circuit->ConnectOutToIn( feedback, 0, feedback, 0 );
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        circuit->Tick();
+    }
+
+    REQUIRE( probe->Count() == 40 );
+    REQUIRE( probe->MismatchCount() == 0 );
+}
+
+TEST_CASE( "WideCircuitOptimizeTest" )
+{
+    // Configure a circuit where a counter fans out to 3000 pass-through -> probe branches
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    circuit->AddComponent( counter );
+
+    std::vector<std::shared_ptr<NoOutputProbe>> probes;
+    for ( int i = 0; i < 3000; ++i )
+    {
+        auto passthrough = std::make_shared<PassThrough>();
+        probes.emplace_back( std::make_shared<NoOutputProbe>() );
+
+        // add probes first so that the optimizer has some ordering to do
+        circuit->AddComponent( probes.back() );
+        circuit->AddComponent( passthrough );
+
+        circuit->ConnectOutToIn( counter, 0, passthrough, 0 );
+        circuit->ConnectOutToIn( passthrough, 0, probes.back(), 0 );
+    }
+
+    // each level is wide enough to be split across the circuit threads
+    circuit->SetBufferCount( 2 );
+    circuit->SetThreadCount( 2 );
+    circuit->Optimize();
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        circuit->Tick();
+    }
+    circuit->Sync();
+
+    for ( const auto& probe : probes )
+    {
+        REQUIRE( probe->Count() == 10 );
+        REQUIRE( probe->MismatchCount() == 0 );
+    }
+}
+
+TEST_CASE( "IdleAutoTickTest" )
+{
+    // Configure a circuit where an injector feeds a probe, auto-ticking only when there's data
+    auto circuit = std::make_shared<Circuit>();
+
+    auto injector = std::make_shared<Injector<int>>( 16, Injector<int>::EmptyPolicy::EmitNothing, Injector<int>::FullPolicy::Block );
+    auto probe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( injector );
+    circuit->AddComponent( probe );
+
+    circuit->ConnectOutToIn( injector, 0, probe, 0 );
+
+    circuit->SetTransferStatsEnabled( true );
+
+    REQUIRE( circuit->IsIdle() );
+
+    circuit->StartAutoTick( Circuit::AutoTickMode::IdleAware );
+
+    // While the injector is empty, the circuit should barely tick
+    std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+
+    circuit->PauseAutoTick();
+    auto stats = probe->GetTransferStats( 0 );
+    REQUIRE( stats.empties + stats.moves + stats.copies < 10 );
+    circuit->ResumeAutoTick();
+
+    // Pushed values should wake the circuit up
+    std::thread producer( [&injector] {
+        for ( int i = 0; i < 1000; ++i )
+        {
+            REQUIRE( injector->Push( i ) );
+        }
+    } );
+    producer.join();
+
+    while ( probe->Count() != 1000 )
+    {
+        std::this_thread::yield();
+    }
+
+    REQUIRE( circuit->IsIdle() );
+
+    // Pausing and stopping a parked auto-tick thread should not hang
+    circuit->PauseAutoTick();
+    circuit->ResumeAutoTick();
+    circuit->StopAutoTick();
+
+    REQUIRE( probe->MismatchCount() == 0 );
+}
+
+TEST_CASE( "RunToCompletionTest" )
+{
+    for ( int bufferCount : { 0, 3 } )
+    {
+        for ( int threadCount : { 0, 2 } )
+        {
+            // Configure a circuit where a finite counter feeds a probe via a pass-through
+            auto circuit = std::make_shared<Circuit>();
+
+            auto counter = std::make_shared<FiniteCounter>( 1000 );
+            auto passThrough = std::make_shared<PassThrough>();
+            auto probe = std::make_shared<NoOutputProbe>();
+
+            circuit->AddComponent( counter );
+            circuit->AddComponent( passThrough );
+            circuit->AddComponent( probe );
+
+            circuit->ConnectOutToIn( counter, 0, passThrough, 0 );
+            circuit->ConnectOutToIn( passThrough, 0, probe, 0 );
+
+            // A stray source that never ends its stream should not hold up the run
+            circuit->AddComponent( std::make_shared<Counter>() );
+
+            circuit->SetBufferCount( bufferCount );
+            circuit->SetThreadCount( threadCount );
+
+            // Every value should reach the probe, along with EOS
+            circuit->RunToCompletion();
+
+            REQUIRE( probe->Count() == 1000 );
+
+            bool probeEnded = false;
+            for ( int i = 0; i < std::max( bufferCount, 1 ); ++i )
+            {
+                probeEnded |= probe->IsEndOfStream( i );
+            }
+            REQUIRE( probeEnded );
+
+            // A completed run should not tick again
+            circuit->RunToCompletion();
+            REQUIRE( probe->Count() == 1000 );
+            REQUIRE( probe->MismatchCount() == 0 );
+
+            probe->ResetEndOfStream();
+            REQUIRE( !probe->IsEndOfStream( 0 ) );
+        }
+    }
+}
+
+TEST_CASE( "DeferredIOTest" )
+{
+    // Configure a circuit where a counter feeds a probe via a resizable component
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto resizer = std::make_shared<Resizer>();
+    auto probe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( resizer );
+    circuit->AddComponent( probe );
+
+    circuit->ConnectOutToIn( counter, 0, resizer, 0 );
+    circuit->ConnectOutToIn( resizer, 0, probe, 0 );
+
+    circuit->SetBufferCount( 3 );
+    circuit->StartAutoTick();
+
+    // Grow the resizer's IO while the circuit is ticking
+    resizer->Resize( 4 );
+
+    while ( resizer->SeenIOCount() != 4 )
+    {
+        std::this_thread::yield();
+    }
+
+    REQUIRE( resizer->GetInputCount() == 4 );
+    REQUIRE( resizer->GetOutputCount() == 4 );
+
+    // Route a second counter through one of the new IOs
+    auto counter2 = std::make_shared<Counter>();
+    auto probe2 = std::make_shared<NoOutputProbe>();
+
+    circuit->PauseAutoTick();
+
+    circuit->AddComponent( counter2 );
+    circuit->AddComponent( probe2 );
+
+    circuit->ConnectOutToIn( counter2, 0, resizer, 3 );
+    circuit->ConnectOutToIn( resizer, 3, probe2, 0 );
+
+    circuit->ResumeAutoTick();
+
+    while ( probe2->Count() < 100 )
+    {
+        std::this_thread::yield();
+    }
+
+    // Shrink the resizer's IO, which should disconnect the second counter and probe
+    resizer->Resize( 1 );
+
+    while ( resizer->SeenIOCount() != 1 )
+    {
+        std::this_thread::yield();
+    }
+
+    int wireCount = 0;
+    probe2->ForEachInputWire( [&wireCount]( Component*, int, int ) { ++wireCount; } );
+    REQUIRE( wireCount == 0 );
+
+    // The first probe should continue receiving values in order
+    const auto count = probe->Count();
+
+    while ( probe->Count() < count + 100 )
+    {
+        std::this_thread::yield();
+    }
+
+    circuit->StopAutoTick();
+
+    REQUIRE( probe->MismatchCount() == 0 );
+    REQUIRE( probe2->MismatchCount() == 0 );
+
+    // A component that outlives its circuit applies its requests straight away (that circuit is gone)
+    auto orphan = std::make_shared<Resizer>();
+    {
+        auto orphanCircuit = std::make_shared<Circuit>();
+        orphanCircuit->AddComponent( orphan );
+    }
+    orphan->Resize( 2 );
+    REQUIRE( orphan->GetInputCount() == 2 );
+    REQUIRE( orphan->GetOutputCount() == 2 );
+}
+
+TEST_CASE( "PerfCountersTest" )
+{
+    // Configure a circuit where a counter feeds a probe via a pass-through
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto passThrough = std::make_shared<PassThrough>();
+    auto probe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( passThrough );
+    circuit->AddComponent( probe );
+
+    circuit->ConnectOutToIn( counter, 0, passThrough, 0 );
+    circuit->ConnectOutToIn( passThrough, 0, probe, 0 );
+
+    circuit->SetPerfCountersEnabled( true );
+
+    for ( int i = 0; i < 100; ++i )
+    {
+        circuit->Tick();
+    }
+
+    // Counts should be attributed to each component where counters are available, and stay 0 otherwise
+    auto counts = passThrough->GetPerfCounts();
+
+    if ( PerfCounters::IsAvailable() )
+    {
+        REQUIRE( counts.instructions > 0 );
+        REQUIRE( counts.cycles > 0 );
+    }
+    else
+    {
+        REQUIRE( counts.instructions == 0 );
+        REQUIRE( counts.cycles == 0 );
+        REQUIRE( counts.cacheMisses == 0 );
+        REQUIRE( counts.branchMisses == 0 );
+    }
+
+    passThrough->ResetPerfCounts();
+    REQUIRE( passThrough->GetPerfCounts().instructions == 0 );
+
+    REQUIRE( probe->MismatchCount() == 0 );
+}
+
+#ifdef DSPATCH_USDT_STUB
+TEST_CASE( "UsdtProbeTest" )
+{
+    // Configure a circuit where a counter feeds a probe
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto probe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( probe );
+
+    circuit->ConnectOutToIn( counter, 0, probe, 0 );
+
+    UsdtProbes::Reset();
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        circuit->Tick();
+    }
+
+    // Each tick, and each component's Process_() call in it, should fire its probes once (after one optimization)
+    REQUIRE( UsdtProbes::Count( "dspatch:optimize_begin" ) == 1 );
+    REQUIRE( UsdtProbes::Count( "dspatch:optimize_end" ) == 1 );
+    REQUIRE( UsdtProbes::Count( "dspatch:tick_begin" ) == 10 );
+    REQUIRE( UsdtProbes::Count( "dspatch:tick_end" ) == 10 );
+    REQUIRE( UsdtProbes::Count( "dspatch:process_begin" ) == 20 );
+    REQUIRE( UsdtProbes::Count( "dspatch:process_end" ) == 20 );
+
+    // In-order components in a multi-buffered circuit wait for their turn to process
+    circuit->SetBufferCount( 2 );
+    UsdtProbes::Reset();
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        circuit->Tick();
+    }
+    circuit->Sync();
+
+    REQUIRE( UsdtProbes::Count( "dspatch:release_wait_begin" ) == 20 );
+    REQUIRE( UsdtProbes::Count( "dspatch:release_wait_end" ) == 20 );
+
+    REQUIRE( probe->MismatchCount() == 0 );
+}
+#endif
+
+TEST_CASE( "AnalyzerTest" )
+{
+    // Configure a circuit where a counter feeds 2 parallel branches of different cost
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto branchA = std::make_shared<PassThrough>();
+    auto branchB = std::make_shared<PassThrough>();
+    auto adder = std::make_shared<Adder>();
+    auto probe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( branchA );
+    circuit->AddComponent( branchB );
+    circuit->AddComponent( adder );
+    circuit->AddComponent( probe );
+
+    std::vector<double> costs( 5 );
+    costs.at( circuit->GetComponentHandle( counter ) ) = 1.0;
+    costs.at( circuit->GetComponentHandle( branchA ) ) = 5.0;
+    costs.at( circuit->GetComponentHandle( branchB ) ) = 3.0;
+    costs.at( circuit->GetComponentHandle( adder ) ) = 1.0;
+    costs.at( circuit->GetComponentHandle( probe ) ) = 1.0;
+
+    circuit->ConnectOutToIn( counter, 0, branchA, 0 );
+    circuit->ConnectOutToIn( counter, 0, branchB, 0 );
+    circuit->ConnectOutToIn( branchA, 0, adder, 0 );
+    circuit->ConnectOutToIn( branchB, 0, adder, 1 );
+    circuit->ConnectOutToIn( adder, 0, probe, 0 );
+
+    auto analyzer = circuit->Analyze( costs );
+
+    // The critical path should run through the costlier branch
+    REQUIRE( analyzer.GetTotalCost() == 11.0 );
+    REQUIRE( analyzer.GetCriticalPathCost() == 8.0 );
+    REQUIRE( analyzer.GetCriticalPath() ==
+             std::vector<int>{ circuit->GetComponentHandle( counter ), circuit->GetComponentHandle( branchA ),
+                               circuit->GetComponentHandle( adder ), circuit->GetComponentHandle( probe ) } );
+    REQUIRE( analyzer.GetSpeedupBound() == 11.0 / 8.0 );
+
+    // Both branches should share a level
+    const auto& levels = analyzer.GetLevels();
+    REQUIRE( levels.size() == 4 );
+    REQUIRE( levels[1].nodeCount == 2 );
+    REQUIRE( levels[1].cost == 8.0 );
+
+    // A single thread runs everything in series, while 2 threads run the branches side by side
+    REQUIRE( analyzer.Simulate( 0, 0 ).tickInterval == 11.0 );
+    REQUIRE( analyzer.Simulate( 0, 2 ).tickInterval == 8.0 );
+
+    // Buffers pipeline ticks, bound only by in-order components
+    REQUIRE( analyzer.Simulate( 3, 0 ).tickInterval < 4.0 );
+
+    auto predictions = analyzer.Predict( 3, 2 );
+    REQUIRE( predictions.size() == 12 );
+    for ( const auto& prediction : predictions )
+    {
+        REQUIRE( prediction.tickInterval <= 11.0 );
+        REQUIRE( prediction.throughput > 0.0 );
+    }
+}
+
+TEST_CASE( "PartitionedSchedulingTest" )
+{
+    // Configure a circuit where a counter fans out into 3 chains of pass-throughs, each ending in a probe
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    circuit->AddComponent( counter );
+
+    std::vector<std::shared_ptr<NoOutputProbe>> probes;
+
+    for ( int i = 0; i < 3; ++i )
+    {
+        Component::SPtr last = counter;
+
+        for ( int j = 0; j < 10; ++j )
+        {
+            auto passThrough = std::make_shared<PassThrough>();
+            circuit->AddComponent( passThrough );
+            circuit->ConnectOutToIn( last, 0, passThrough, 0 );
+            last = passThrough;
+        }
+
+        probes.emplace_back( std::make_shared<NoOutputProbe>() );
+        circuit->AddComponent( probes.back() );
+        circuit->ConnectOutToIn( last, 0, probes.back(), 0 );
+    }
+
+    circuit->SetThreadCount( 2 );
+    circuit->Optimize();
+
+    // Round-robin scheduling should send nearly every wire across threads
+    const auto strideWireCount = circuit->GetCrossThreadWireCount();
+    REQUIRE( strideWireCount > 20 );
+
+    // Partitioning should keep most wires within a thread
+    circuit->SetScheduling( Circuit::Scheduling::Partitioned );
+    circuit->Optimize();
+
+    const auto partitionedWireCount = circuit->GetCrossThreadWireCount();
+    REQUIRE( partitionedWireCount < strideWireCount / 4 );
+
+    // Every probe should receive every value in order, with and without buffering
+    for ( int i = 0; i < 1000; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->SetBufferCount( 3 );
+
+    for ( int i = 0; i < 1000; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->SetScheduling( Circuit::Scheduling::Stride );
+
+    for ( int i = 0; i < 1000; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->Sync();
+
+    for ( const auto& probe : probes )
+    {
+        REQUIRE( probe->Count() >= 2997 );
+        REQUIRE( probe->MismatchCount() == 0 );
+    }
+
+    // A component removed (and destroyed) since the last optimization is no longer counted
+    circuit->RemoveComponent( probes.back() );
+    probes.pop_back();
+    REQUIRE( circuit->GetCrossThreadWireCount() <= strideWireCount );
+}
+
+TEST_CASE( "BorrowedViewTest" )
+{
+    std::vector<int> frames( 3000 );
+    std::iota( frames.begin(), frames.end(), 0 );
+
+    std::atomic<int> releaseCount( 0 );
+
+    {
+        // Configure a circuit where a borrowing counter fans out to 2 probes
+        auto circuit = std::make_shared<Circuit>();
+
+        auto counter = std::make_shared<BorrowingCounter>( frames.data(), releaseCount );
+        auto probe1 = std::make_shared<BorrowedProbe>( frames.data() );
+        auto probe2 = std::make_shared<BorrowedProbe>( frames.data() );
+
+        circuit->AddComponent( counter );
+        circuit->AddComponent( probe1 );
+        circuit->AddComponent( probe2 );
+
+        circuit->ConnectOutToIn( counter, 0, probe1, 0 );
+        circuit->ConnectOutToIn( counter, 0, probe2, 0 );
+
+        // Each frame should be released once both probes are done with it (the last is still held by the probes)
+        for ( int i = 0; i < 1000; ++i )
+        {
+            circuit->Tick();
+        }
+
+        REQUIRE( releaseCount == 999 );
+
+        // Views should be shared and released just the same across buffers and threads
+        circuit->SetBufferCount( 3 );
+        circuit->SetThreadCount( 2 );
+
+        for ( int i = 0; i < 2000; ++i )
+        {
+            circuit->Tick();
+        }
+
+        circuit->Sync();
+
+        REQUIRE( probe1->Count() == 3000 );
+        REQUIRE( probe2->Count() == 3000 );
+    }
+
+    // Every frame should be released once the circuit is gone
+    REQUIRE( releaseCount == 3000 );
+}
+
+TEST_CASE( "MemoryBudgetTest" )
+{
+    SignalBus::SetSizeHook<std::vector<int>>( []( const std::vector<int>& value ) { return value.size() * sizeof( int ); } );
+
+    // Configure a circuit where a growing counter feeds a chain of 2 pass-throughs
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<GrowingCounter>( 10 );
+    auto passThrough1 = std::make_shared<PassThrough>();
+    auto passThrough2 = std::make_shared<PassThrough>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( passThrough1 );
+    circuit->AddComponent( passThrough2 );
+
+    circuit->ConnectOutToIn( counter, 0, passThrough1, 0 );
+    circuit->ConnectOutToIn( passThrough1, 0, passThrough2, 0 );
+
+    // Notify: payloads pass through untouched, and the callback fires once the budget is exceeded
+    std::atomic<int> exceededCount( 0 );
+    auto budget = std::make_shared<MemoryBudget>( 1000, MemoryBudget::Policy::Notify, [&exceededCount]( size_t usage ) {
+        REQUIRE( usage > 1000 );
+        ++exceededCount;
+    } );
+    circuit->SetMemoryBudget( budget );
+
+    for ( int i = 0; i < 30; ++i )
+    {
+        circuit->Tick();
+    }
+
+    // a payload moving along the chain is only accounted once (at the last output holding it)
+    REQUIRE( budget->GetUsage() == 30 * 10 * sizeof( int ) );
+    REQUIRE( budget->IsExceeded() );
+    REQUIRE( exceededCount != 0 );
+
+    // usage no longer drops back within the limit between payloads, so the callback doesn't fire again
+    int lastExceededCount = exceededCount;
+    circuit->Tick();
+    REQUIRE( exceededCount == lastExceededCount );
+
+    // removing the budget releases everything accounted against it
+    circuit->SetMemoryBudget( nullptr );
+    REQUIRE( budget->GetUsage() == 0 );
+
+    // Drop: payloads that don't fit are dropped at the counter's output, so usage never exceeds the limit
+    budget = std::make_shared<MemoryBudget>( 1000, MemoryBudget::Policy::Drop );
+    circuit->SetBufferCount( 3 );
+    circuit->SetMemoryBudget( budget );
+
+    for ( int i = 0; i < 30; ++i )
+    {
+        circuit->Tick();
+        REQUIRE( budget->GetUsage() <= 1000 );
+    }
+
+    circuit->Sync();
+
+    REQUIRE( budget->GetDropCount() != 0 );
+    REQUIRE( budget->IsExceeded() );
+
+    // Throttle: the auto-tick slows down while over budget, but payloads are untouched
+    budget = std::make_shared<MemoryBudget>( 1000, MemoryBudget::Policy::Throttle );
+    circuit->SetMemoryBudget( budget );
+    circuit->StartAutoTick();
+
+    while ( !budget->IsExceeded() )
+    {
+        std::this_thread::yield();
+    }
+
+    circuit->StopAutoTick();
+
+    REQUIRE( budget->GetDropCount() == 0 );
+
+    // removing components releases their payloads too
+    circuit->RemoveComponent( counter );
+    circuit->RemoveComponent( passThrough1 );
+    circuit->RemoveComponent( passThrough2 );
+    REQUIRE( budget->GetUsage() == 0 );
+
+    // Fan-out: a payload feeding 2 wires is accounted twice (once per copy), so 40 bytes don't fit within 60
+    counter = std::make_shared<GrowingCounter>( 10 );
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( passThrough1 );
+    circuit->AddComponent( passThrough2 );
+
+    circuit->ConnectOutToIn( counter, 0, passThrough1, 0 );
+    circuit->ConnectOutToIn( counter, 0, passThrough2, 0 );
+
+    circuit->SetBufferCount( 1 );
+    budget = std::make_shared<MemoryBudget>( 60, MemoryBudget::Policy::Drop );
+    circuit->SetMemoryBudget( budget );
+
+    circuit->Tick();
+
+    REQUIRE( budget->GetDropCount() == 1 );
+    REQUIRE( budget->GetUsage() == 0 );
+
+    // Unhooked types: payloads without a size hook count as 0 bytes, so are never dropped
+    SignalBus::SetSizeHook<int>( nullptr );
+
+    auto intCounter = std::make_shared<Counter>();
+    circuit->AddComponent( intCounter );
+    circuit->ConnectOutToIn( intCounter, 0, passThrough1, 0 );
+
+    budget = std::make_shared<MemoryBudget>( 1, MemoryBudget::Policy::Drop );
+    circuit->SetMemoryBudget( budget );
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        circuit->Tick();
+    }
+
+    REQUIRE( budget->GetDropCount() == 10 );  // (the growing counter's vectors only)
+    REQUIRE( budget->GetUsage() == 0 );
+
+    SignalBus::SetSizeHook<int>( []( const int& ) { return sizeof( int ); } );
+}
+
+TEST_CASE( "ClockBridgeTest" )
+{
+    // Configure a circuit where a clock bridge's source feeds its sink via a pass-through
+    auto circuit = std::make_shared<Circuit>();
+
+    ClockBridge<int, int> bridge( 4 );
+    auto passThrough = std::make_shared<PassThrough>();
+
+    circuit->AddComponent( bridge.GetSource() );
+    circuit->AddComponent( passThrough );
+    circuit->AddComponent( bridge.GetSink() );
+
+    circuit->ConnectOutToIn( bridge.GetSource(), 0, passThrough, 0 );
+    circuit->ConnectOutToIn( passThrough, 0, bridge.GetSink(), 0 );
+
+    // the first "latency" periods receive default blocks, then the circuit misses its deadline
+    int output = -1;
+    for ( int i = 1; i <= 4; ++i )
+    {
+        REQUIRE( bridge.Exchange( i, output ) );
+        REQUIRE( output == 0 );
+    }
+    REQUIRE( !bridge.Exchange( 5, output ) );
+    REQUIRE( output == 0 );
+    REQUIRE( bridge.GetUnderrunCount() == 1 );
+
+    // once the circuit catches up, the late block is discarded and the latency is unchanged
+    for ( int i = 0; i < 5; ++i )
+    {
+        circuit->Tick();
+    }
+    REQUIRE( bridge.Exchange( 6, output ) );
+    REQUIRE( output == 2 );
+    REQUIRE( bridge.Exchange( 7, output ) );
+    REQUIRE( output == 3 );
+
+    // now let the circuit run ahead on its own threads
+    circuit->SetBufferCount( 2 );
+    circuit->StartAutoTick();
+
+    for ( int i = 8; i < 500; ++i )
+    {
+        std::this_thread::sleep_for( std::chrono::microseconds( 200 ) );
+
+        // a block that arrives is always the one produced "latency" periods ago (unless an input block was lost to an overrun)
+        if ( bridge.Exchange( i, output ) && bridge.GetOverrunCount() == 0 )
+        {
+            REQUIRE( output == i - 4 );
+        }
+    }
+
+    // stopping the auto-tick without closing the bridge first doesn't deadlock (the source gives up waiting eventually)
+    circuit->StopAutoTick();
+
+    // once closed, ticks are skipped by the sink too, so no output blocks pile up (and are dropped) at the ring
+    bridge.Close();
+    const auto outputDropCount = bridge.GetOutputDropCount();
+
+    for ( int i = 0; i < 20; ++i )
+    {
+        circuit->Tick();
+    }
+    circuit->Sync();
+
+    REQUIRE( bridge.GetOutputDropCount() == outputDropCount );
+}
+
+TEST_CASE( "LazyInputsTest" )
+{
+    // Configure a circuit where 4 counters feed a selector that only reads one of its inputs per tick
+    auto circuit = std::make_shared<Circuit>();
+
+    auto selector = std::make_shared<LazySelector>( 4 );
+    auto selectorProbe = std::make_shared<NoOutputProbe>();
+    auto counterProbe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( selector );
+    circuit->AddComponent( selectorProbe );
+    circuit->AddComponent( counterProbe );
+
+    for ( int i = 0; i < 4; ++i )
+    {
+        auto counter = std::make_shared<Counter>();
+        circuit->AddComponent( counter );
+        circuit->ConnectOutToIn( counter, 0, selector, i );
+
+        // the first counter fans out to another probe too, which must still receive every value
+        if ( i == 0 )
+        {
+            circuit->ConnectOutToIn( counter, 0, counterProbe, 0 );
+        }
+    }
+
+    circuit->ConnectOutToIn( selector, 0, selectorProbe, 0 );
+
+    selector->SetTransferStatsEnabled( true );
+
+    for ( int i = 0; i < 1000; ++i )
+    {
+        circuit->Tick();
+    }
+
+    // only the input read on each tick was transferred
+    uint64_t transfers = 0;
+    for ( int i = 0; i < 4; ++i )
+    {
+        auto stats = selector->GetTransferStats( i );
+        REQUIRE( stats.empties == 0 );
+        transfers += stats.moves + stats.copies;
+    }
+    REQUIRE( transfers == 1000 );
+
+    REQUIRE( selectorProbe->Count() == 1000 );
+    REQUIRE( counterProbe->Count() == 1000 );
+
+    // the same holds across buffers and threads
+    circuit->SetBufferCount( 3 );
+    circuit->SetThreadCount( 2 );
+
+    for ( int i = 0; i < 1000; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->Sync();
+
+    REQUIRE( selectorProbe->Count() == 2000 );
+    REQUIRE( counterProbe->Count() == 2000 );
+
+    REQUIRE( selectorProbe->MismatchCount() == 0 );
+    REQUIRE( counterProbe->MismatchCount() == 0 );
+}
+
+TEST_CASE( "LazyFanOutTest" )
+{
+    // Configure a circuit where a counter that outputs on every other tick feeds a lazy selector and 2 eager probes
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<AlternatingCounter>();
+    auto selector = std::make_shared<LazySelector>( 2 );
+    auto selectorProbe = std::make_shared<NoOutputProbe>();
+    auto probe1 = std::make_shared<NoOutputProbe>();
+    auto probe2 = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( selector );
+    circuit->AddComponent( selectorProbe );
+    circuit->AddComponent( probe1 );
+    circuit->AddComponent( probe2 );
+
+    // the selector reads the counter on the ticks it outputs, and skips it (reading its other input) on the ticks it doesn't
+    circuit->ConnectOutToIn( counter, 0, selector, 0 );
+    circuit->ConnectOutToIn( counter, 0, probe1, 0 );
+    circuit->ConnectOutToIn( counter, 0, probe2, 0 );
+    circuit->ConnectOutToIn( selector, 0, selectorProbe, 0 );
+
+    for ( int i = 0; i < 1000; ++i )
+    {
+        circuit->Tick();
+    }
+
+    // skipping an empty output mustn't throw its reference count out, leaving a later value moved away from an eager probe
+    REQUIRE( selectorProbe->Count() == 500 );
+    REQUIRE( probe1->Count() == 500 );
+    REQUIRE( probe2->Count() == 500 );
+
+    // the same holds across buffers and threads
+    circuit->SetBufferCount( 3 );
+    circuit->SetThreadCount( 2 );
+
+    for ( int i = 0; i < 1000; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->Sync();
+
+    REQUIRE( selectorProbe->Count() == 1000 );
+    REQUIRE( probe1->Count() == 1000 );
+    REQUIRE( probe2->Count() == 1000 );
+
+    REQUIRE( selectorProbe->MismatchCount() == 0 );
+    REQUIRE( probe1->MismatchCount() == 0 );
+    REQUIRE( probe2->MismatchCount() == 0 );
+}
+
+#ifdef DSPATCH_COROUTINES
+TEST_CASE( "AsyncComponentTest" )
+{
+    // Configure a circuit where a counter feeds a probe via an async pass-through
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto passThrough = std::make_shared<AsyncPassThrough>();
+    auto probe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( passThrough );
+    circuit->AddComponent( probe );
+
+    circuit->ConnectOutToIn( counter, 0, passThrough, 0 );
+    circuit->ConnectOutToIn( passThrough, 0, probe, 0 );
+
+    for ( int i = 0; i < 50; ++i )
+    {
+        circuit->Tick();
+    }
+
+    REQUIRE( probe->Count() == 50 );
+    REQUIRE( passThrough->MaxInFlight() == 1 );
+
+    // with multiple buffers, in-order coroutines still run one at a time, in buffer order
+    circuit->SetBufferCount( 4 );
+
+    for ( int i = 0; i < 200; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->Sync();
+
+    REQUIRE( probe->Count() == 250 );
+    REQUIRE( passThrough->MaxInFlight() == 1 );
+
+    REQUIRE( passThrough->MismatchCount() == 0 );
+    REQUIRE( probe->MismatchCount() == 0 );
+
+    // out-of-order coroutines let the next buffers start their own waits
+    auto freeCounter = std::make_shared<Counter>();
+    auto freePassThrough = std::make_shared<AsyncPassThrough>( Component::ProcessOrder::OutOfOrder );
+    auto freeProbe = std::make_shared<NoOutputProbe>();
+
+    circuit->AddComponent( freeCounter );
+    circuit->AddComponent( freePassThrough );
+    circuit->AddComponent( freeProbe );
+
+    circuit->ConnectOutToIn( freeCounter, 0, freePassThrough, 0 );
+    circuit->ConnectOutToIn( freePassThrough, 0, freeProbe, 0 );
+
+    for ( int i = 0; i < 200; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->Sync();
+
+    REQUIRE( freeProbe->Count() == 200 );
+    REQUIRE( freePassThrough->MaxInFlight() > 1 );
+
+    REQUIRE( freeProbe->MismatchCount() == 0 );
+}
+#endif
+
+TEST_CASE( "RateDivisorTest" )
+{
+    // Configure a circuit where a counter feeds a chain of 2 recorders at a quarter rate, followed by a full rate recorder
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto slow1 = std::make_shared<RateRecorder>();
+    auto slow2 = std::make_shared<RateRecorder>();
+    auto fast = std::make_shared<RateRecorder>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( slow1 );
+    circuit->AddComponent( slow2 );
+    circuit->AddComponent( fast );
+
+    circuit->ConnectOutToIn( counter, 0, slow1, 0 );
+    circuit->ConnectOutToIn( slow1, 0, slow2, 0 );
+    circuit->ConnectOutToIn( slow2, 0, fast, 0 );
+
+    REQUIRE( circuit->SetRateDivisor( slow1, 4 ) );
+    REQUIRE( circuit->SetRateDivisor( slow2, 4 ) );
+    REQUIRE( slow1->GetRateDivisor() == 4 );
+
+    for ( int i = 0; i < 100; ++i )
+    {
+        circuit->Tick();
+    }
+
+    // the quarter rate recorders sample every 4th count, and the full rate recorder holds each sample for 4 ticks
+    REQUIRE( slow1->Values().size() == 25 );
+    REQUIRE( slow2->Values().size() == 25 );
+    REQUIRE( fast->Values().size() == 100 );
+
+    for ( int i = 0; i < 25; ++i )
+    {
+        REQUIRE( slow1->Values()[i] == i * 4 );
+        REQUIRE( slow2->Values()[i] == i * 4 );
+    }
+    for ( int i = 0; i < 100; ++i )
+    {
+        REQUIRE( fast->Values()[i] == i / 4 * 4 );
+    }
+
+    // off-rate ticks keep their place in the buffer order, across buffers and threads
+    circuit->SetBufferCount( 3 );
+    circuit->SetThreadCount( 2 );
+
+    for ( int i = 0; i < 100; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->Sync();
+
+    REQUIRE( slow1->Values().size() == 50 );
+    REQUIRE( slow2->Values().size() == 50 );
+    REQUIRE( fast->Values().size() == 200 );
+
+    // back at full rate, wires no longer hold values
+    circuit->SetThreadCount( 0 );
+    circuit->SetBufferCount( 0 );
+    REQUIRE( circuit->SetRateDivisor( slow1, 1 ) );
+    REQUIRE( circuit->SetRateDivisor( slow2, 1 ) );
+
+    for ( int i = 0; i < 10; ++i )
+    {
+        circuit->Tick();
+    }
+
+    REQUIRE( slow2->Values().size() == 60 );
+    REQUIRE( fast->Values().back() == counter->Count() - 1 );
+
+    // end-of-stream crosses held wires too, across buffers and threads
+    auto finiteCircuit = std::make_shared<Circuit>();
+
+    auto finite = std::make_shared<FiniteCounter>( 10 );
+    auto recorder = std::make_shared<RateRecorder>();
+
+    finiteCircuit->AddComponent( finite );
+    finiteCircuit->AddComponent( recorder );
+    finiteCircuit->ConnectOutToIn( finite, 0, recorder, 0 );
+
+    REQUIRE( finiteCircuit->SetRateDivisor( finite, 4 ) );
+    finiteCircuit->SetBufferCount( 3 );
+    finiteCircuit->SetThreadCount( 2 );
+
+    finiteCircuit->RunToCompletion();
+
+    REQUIRE( recorder->Values().size() >= 36 );
+    REQUIRE( recorder->Values().back() <= 9 );
+}
+
+TEST_CASE( "CircuitBridgeTest" )
+{
+    // Configure 2 circuits joined by a bridge: counter -> sender | receiver -> recorder
+    auto makeCircuits = []( CircuitBridge<int>& bridge, std::shared_ptr<RateRecorder>& recorder ) {
+        auto sendCircuit = std::make_shared<Circuit>();
+        auto receiveCircuit = std::make_shared<Circuit>();
+
+        auto counter = std::make_shared<Counter>( 4 );
+        recorder = std::make_shared<RateRecorder>();
+
+        sendCircuit->AddComponent( counter );
+        sendCircuit->AddComponent( bridge.GetSender() );
+        sendCircuit->ConnectOutToIn( counter, 0, bridge.GetSender(), 0 );
+
+        receiveCircuit->AddComponent( bridge.GetReceiver() );
+        receiveCircuit->AddComponent( recorder );
+        receiveCircuit->ConnectOutToIn( bridge.GetReceiver(), 0, recorder, 0 );
+
+        return std::make_pair( sendCircuit, receiveCircuit );
+    };
+
+    std::shared_ptr<RateRecorder> recorder;
+
+    // Repeat: the receiving circuit ticks 4 times per sent value, repeating each
+    CircuitBridge<int> repeater( 8, CircuitBridge<int>::UnderflowPolicy::Repeat );
+    auto [sendCircuit, receiveCircuit] = makeCircuits( repeater, recorder );
+
+    for ( int i = 0; i < 40; ++i )
+    {
+        if ( i % 4 == 0 )
+        {
+            sendCircuit->Tick();
+        }
+        receiveCircuit->Tick();
+    }
+    for ( int i = 0; i < 40; ++i )
+    {
+        REQUIRE( recorder->Values()[i] == i / 4 * 4 );
+    }
+    REQUIRE( repeater.GetUnderflowCount() == 30 );
+
+    // Drop: underflowing ticks receive nothing
+    CircuitBridge<int> dropper( 8, CircuitBridge<int>::UnderflowPolicy::Drop );
+    std::tie( sendCircuit, receiveCircuit ) = makeCircuits( dropper, recorder );
+
+    for ( int i = 0; i < 8; ++i )
+    {
+        if ( i % 4 == 0 )
+        {
+            sendCircuit->Tick();
+        }
+        receiveCircuit->Tick();
+    }
+    REQUIRE( recorder->Values() == std::vector<int>{ 0, -1, -1, -1, 4, -1, -1, -1 } );
+
+    // Interpolate: values ramp linearly from one arrival to the next (one arrival behind)
+    CircuitBridge<int> interpolator( 8, CircuitBridge<int>::UnderflowPolicy::Interpolate );
+    std::tie( sendCircuit, receiveCircuit ) = makeCircuits( interpolator, recorder );
+
+    for ( int i = 0; i < 40; ++i )
+    {
+        if ( i % 4 == 0 )
+        {
+            sendCircuit->Tick();
+        }
+        receiveCircuit->Tick();
+    }
+    for ( int i = 4; i < 40; ++i )
+    {
+        REQUIRE( recorder->Values()[i] == i - 4 );
+    }
+
+    // Overflow: DropNewest keeps the oldest values, DropOldest the newest
+    CircuitBridge<int> keepOldest( 4, CircuitBridge<int>::UnderflowPolicy::Drop, CircuitBridge<int>::OverflowPolicy::DropNewest );
+    std::tie( sendCircuit, receiveCircuit ) = makeCircuits( keepOldest, recorder );
+
+    for ( int i = 0; i < 6; ++i )
+    {
+        sendCircuit->Tick();
+    }
+    for ( int i = 0; i < 4; ++i )
+    {
+        receiveCircuit->Tick();
+    }
+    REQUIRE( recorder->Values() == std::vector<int>{ 0, 4, 8, 12 } );
+    REQUIRE( keepOldest.GetOverflowCount() == 2 );
+
+    CircuitBridge<int> keepNewest( 4, CircuitBridge<int>::UnderflowPolicy::Drop, CircuitBridge<int>::OverflowPolicy::DropOldest );
+    std::tie( sendCircuit, receiveCircuit ) = makeCircuits( keepNewest, recorder );
+
+    for ( int i = 0; i < 6; ++i )
+    {
+        sendCircuit->Tick();
+    }
+    for ( int i = 0; i < 4; ++i )
+    {
+        receiveCircuit->Tick();
+    }
+    REQUIRE( recorder->Values() == std::vector<int>{ 8, 12, 16, 20 } );
+    REQUIRE( keepNewest.GetOverflowCount() == 2 );
+
+    // Both circuits auto-ticking independently: values arrive in order
+    CircuitBridge<int> bridge( 64 );
+    std::tie( sendCircuit, receiveCircuit ) = makeCircuits( bridge, recorder );
+
+    sendCircuit->StartAutoTick();
+    receiveCircuit->StartAutoTick();
+
+    std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+
+    receiveCircuit->StopAutoTick();
+    sendCircuit->StopAutoTick();
+
+    const auto& values = recorder->Values();
+    REQUIRE( std::is_sorted( values.begin(), values.end() ) );
+}
+
+#ifdef DSPATCH_SIGNAL_METADATA
+TEST_CASE( "SignalMetadataTest" )
+{
+    // Metadata moves and copies with its signal, and is cleared by a new value
+    SignalBus bus;
+    bus.SetSignalCount( 3 );
+
+    bus.SetValue( 0, 42 );
+    REQUIRE( bus.GetMetadata( 0 ).originTime == 0 );
+
+    bus.SetMetadata( 0, { 1000, 7 } );
+    bus.SetSignal( 1, bus, 0 );
+    REQUIRE( *bus.GetValue<int>( 1 ) == 42 );
+    REQUIRE( bus.GetMetadata( 1 ).originTime == 1000 );
+    REQUIRE( bus.GetMetadata( 1 ).originTick == 7 );
+
+    bus.MoveSignal( 2, bus, 0 );
+    REQUIRE( *bus.GetValue<int>( 2 ) == 42 );
+    REQUIRE( bus.GetMetadata( 2 ).originTick == 7 );
+    REQUIRE( !bus.HasValue( 0 ) );
+
+    bus.SetValue( 2, 43 );
+    REQUIRE( bus.GetMetadata( 2 ).originTime == 0 );
+
+    // Configure a circuit where a counter feeds a probe via a slow pass-through and a pass-through
+    auto circuit = std::make_shared<Circuit>();
+
+    auto counter = std::make_shared<Counter>();
+    auto pass1 = std::make_shared<SlowPassThrough>( std::chrono::microseconds( 500 ) );
+    auto pass2 = std::make_shared<PassThrough>();
+    auto probe = std::make_shared<MetadataProbe>();
+
+    circuit->AddComponent( counter );
+    circuit->AddComponent( pass1 );
+    circuit->AddComponent( pass2 );
+    circuit->AddComponent( probe );
+
+    circuit->ConnectOutToIn( counter, 0, pass1, 0 );
+    circuit->ConnectOutToIn( pass1, 0, pass2, 0 );
+    circuit->ConnectOutToIn( pass2, 0, probe, 0 );
+
+    for ( int i = 0; i < 100; ++i )
+    {
+        circuit->Tick();
+    }
+
+    // the counter's values carry their origin all the way through, multi-buffered too
+    circuit->SetBufferCount( 3 );
+
+    for ( int i = 0; i < 300; ++i )
+    {
+        circuit->Tick();
+    }
+
+    circuit->Sync();
+
+    REQUIRE( probe->Count() == 400 );
+    REQUIRE( probe->MismatchCount() == 0 );
+
+    // forwarding an input's signal into an output keeps its origin, so every value has aged by at least the slow hop
+    REQUIRE( probe->MinAge() >= 500 * 1000 );
+}
+#endif
+
 TEST_CASE( "TenThousandComponents" )
 {
     auto begin = std::chrono::high_resolution_clock::now();
@@ -0,0 +1,86 @@
+/******************************************************************************
+DSPatch - The Refreshingly Simple C++ Dataflow Framework
+Copyright (c) 2024, Marcus Tomlinson
+
+BSD 2-Clause License
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+******************************************************************************/
+
+#pragma once
+
+// Stand-in for SystemTap's <sys/sdt.h>, so that the tests can check where DSPATCH_PROBE() fires (see Probes.h)
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#define DSPATCH_USDT_STUB
+
+namespace DSPatch
+{
+
+class UsdtProbes final
+{
+public:
+    static void Fire( const std::string& provider, const std::string& name )
+    {
+        std::lock_guard<std::mutex> lock( _Mutex() );
+        ++_Counts()[provider + ":" + name];
+    }
+
+    static int Count( const std::string& probe )
+    {
+        std::lock_guard<std::mutex> lock( _Mutex() );
+        return _Counts()[probe];
+    }
+
+    static void Reset()
+    {
+        std::lock_guard<std::mutex> lock( _Mutex() );
+        _Counts().clear();
+    }
+
+private:
+    static std::mutex& _Mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    static std::map<std::string, int>& _Counts()
+    {
+        static std::map<std::string, int> counts;
+        return counts;
+    }
+};
+
+}  // namespace DSPatch
+
+// (arguments are evaluated, like a real probe's, so that they must still compile)
+#define DTRACE_PROBE2( provider, name, arg1, arg2 )    \
+    do                                                 \
+    {                                                  \
+        (void)( arg1 );                                \
+        (void)( arg2 );                                \
+        DSPatch::UsdtProbes::Fire( #provider, #name ); \
+    } while ( false )